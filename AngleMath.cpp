@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "AngleMath.h"
+
+namespace
+{
+	// directions on a grid around the origin, including the axes, diagonals and vectors near zero
+	void BuildTestDirections(TArray<FVector2D>& aoDirs)
+	{
+		const int32 iSteps = 512;
+
+		aoDirs.Reserve((2 * iSteps + 1) * (2 * iSteps + 1));
+
+		for (int32 iY = -iSteps; iY <= iSteps; iY++)
+			for (int32 iX = -iSteps; iX <= iSteps; iX++)
+				aoDirs.Add(FVector2D((float)iX / iSteps, (float)iY / iSteps) * (iX & 1 ? 1000.0f : 0.001f));
+	}
+
+	// check FastAtan2 and Wrap against FMath and time FastAtan2 against FMath::Atan2
+	void TestAngleMath()
+	{
+		TArray<FVector2D> aoDirs;
+		BuildTestDirections(aoDirs);
+
+		float fMaxAtanError = 0.0f;
+		FVector2D oWorstDir = FVector2D::ZeroVector;
+
+		for (const FVector2D& oDir : aoDirs)
+		{
+			// atan2 of a zero vector is 0 for both
+			float fError = FMath::Abs(FAngleMath::Diff(FAngleMath::FastAtan2(oDir.Y, oDir.X), FMath::Atan2(oDir.Y, oDir.X)));
+
+			if (fError > fMaxAtanError)
+			{
+				fMaxAtanError = fError;
+				oWorstDir = oDir;
+			}
+		}
+
+		float fMaxWrapError = 0.0f;
+
+		for (float fAngle = -300.0f; fAngle <= 300.0f; fAngle += 0.01f)
+		{
+			float fWrapped = FAngleMath::Wrap(fAngle);
+
+			// distance to the nearest whole turn in double, so the ends of the range count as equal and the check adds no rounding
+			double fTurns = ((double)fWrapped - (double)fAngle) / (2.0 * PI);
+
+			fMaxWrapError = FMath::Max(fMaxWrapError, (float)(FMath::Abs(fTurns - FMath::RoundToDouble(fTurns)) * 2.0 * PI));
+		}
+
+		const int32 iPasses = 8;
+
+		// sums are logged so the loops are not optimized away
+		float fFastSum = 0.0f;
+		double fStartTime = FPlatformTime::Seconds();
+
+		for (int32 iPass = 0; iPass < iPasses; iPass++)
+			for (const FVector2D& oDir : aoDirs)
+				fFastSum += FAngleMath::FastAtan2(oDir.Y, oDir.X);
+
+		double fFastTime = FPlatformTime::Seconds() - fStartTime;
+
+		float fExactSum = 0.0f;
+		fStartTime = FPlatformTime::Seconds();
+
+		for (int32 iPass = 0; iPass < iPasses; iPass++)
+			for (const FVector2D& oDir : aoDirs)
+				fExactSum += FMath::Atan2(oDir.Y, oDir.X);
+
+		double fExactTime = FPlatformTime::Seconds() - fStartTime;
+
+		int32 iCalls = aoDirs.Num() * iPasses;
+
+		UE_LOG(LogTemp, Log, TEXT("FastAtan2: max error %g radians (%g degrees) at (%g, %g) over %d directions"), fMaxAtanError, FMath::RadiansToDegrees(fMaxAtanError), oWorstDir.X, oWorstDir.Y, aoDirs.Num());
+		UE_LOG(LogTemp, Log, TEXT("Wrap: max error %g between -300 and 300 radians"), fMaxWrapError);
+		UE_LOG(LogTemp, Log, TEXT("FastAtan2 %.2f ns/call, FMath::Atan2 %.2f ns/call over %d calls (sums %g, %g)"), fFastTime * 1e9 / iCalls, fExactTime * 1e9 / iCalls, iCalls, fFastSum, fExactSum);
+
+		if (fMaxAtanError > 1.2e-5f)
+			UE_LOG(LogTemp, Warning, TEXT("FastAtan2 error is above the 1.2e-5 radians documented in AngleMath.h"));
+
+		if (fMaxWrapError > 2.2e-5f)
+			UE_LOG(LogTemp, Warning, TEXT("Wrap error is above the 2.2e-5 radians documented in AngleMath.h"));
+	}
+
+	FAutoConsoleCommand GAngleMathTestCommand(
+		TEXT("HNS.AngleMathTest"),
+		TEXT("Log the max error of FastAtan2 and Wrap against FMath and time FastAtan2 against FMath::Atan2"),
+		FConsoleCommandDelegate::CreateStatic(&TestAngleMath));
+}
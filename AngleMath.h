@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// approximate angle functions for targeting and turning - no branches, so loops over many directions vectorize
+// angles are in radians unless the name says degrees - HNS.AngleMathTest checks the errors below and times FastAtan2
+struct FAngleMath
+{
+	// atan2 using the Abramowitz & Stegun 4.4.49 polynomial on the octant - max error 1.2e-5 radians (0.0007 degrees), 0 for a zero vector
+	static FORCEINLINE float FastAtan2(float fY, float fX)
+	{
+		const float fAbsX = FMath::Abs(fX);
+		const float fAbsY = FMath::Abs(fY);
+
+		const float fMax = FMath::Max(fAbsX, fAbsY);
+		const float fMin = FMath::Min(fAbsX, fAbsY);
+
+		// ratio in [0, 1]
+		const float fRatio = fMin / (fMax > 0.0f ? fMax : 1.0f);
+		const float fRatioSq = fRatio * fRatio;
+
+		float fAngle = fRatio * (0.9998660f + fRatioSq * (-0.3302995f + fRatioSq * (0.1801410f + fRatioSq * (-0.0851330f + fRatioSq * 0.0208351f))));
+
+		// back out of the octant
+		fAngle = fAbsY > fAbsX ? HALF_PI - fAngle : fAngle;
+		fAngle = fX < 0.0f ? PI - fAngle : fAngle;
+
+		return fY < 0.0f ? -fAngle : fAngle;
+	}
+
+	// yaw of a direction on the horizontal plane
+	static FORCEINLINE float Yaw(const FVector& oDir)
+	{
+		return FastAtan2(oDir.Y, oDir.X);
+	}
+
+	static FORCEINLINE float YawDegrees(const FVector& oDir)
+	{
+		return FMath::RadiansToDegrees(FastAtan2(oDir.Y, oDir.X));
+	}
+
+	// wrap to [-PI, PI), ends can be off by float rounding - the error grows with the angle, max 3.5e-7 radians within
+	// +-4 PI and 2.2e-5 radians within +-300 radians
+	static FORCEINLINE float Wrap(float fAngle)
+	{
+		return fAngle - (2.0f * PI) * FMath::FloorToFloat(fAngle * (0.5f / PI) + 0.5f);
+	}
+
+	// wrap to [-180, 180)
+	static FORCEINLINE float WrapDegrees(float fAngle)
+	{
+		return fAngle - 360.0f * FMath::FloorToFloat(fAngle * (1.0f / 360.0f) + 0.5f);
+	}
+
+	// shortest signed angle from fFrom to fTo, so angles either side of -PI and PI are close
+	static FORCEINLINE float Diff(float fTo, float fFrom)
+	{
+		return Wrap(fTo - fFrom);
+	}
+
+	// shortest angle between the yaws of two directions - the error is at most twice FastAtan2's
+	static FORCEINLINE float YawDiff(const FVector& oTo, const FVector& oFrom)
+	{
+		return Wrap(Yaw(oTo) - Yaw(oFrom));
+	}
+};
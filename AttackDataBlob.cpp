@@ -0,0 +1,242 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "AttackEntry.h"
+#include "CombatReplication.h"
+#include "AttackDataBlob.h"
+
+namespace
+{
+	TSharedPtr<FAttackDataBlob> GAttackData;
+
+	bool bAttackDataLoaded = false;
+
+	FAutoConsoleCommand GCookAttackDataCommand(
+		TEXT("HNS.CookAttackData"),
+		TEXT("Cook the registered attack entries into the flat attack data file"),
+		FConsoleCommandDelegate::CreateStatic(&FAttackDataBlob::CookToFile));
+
+	uint32 Align(uint32 iOffset)
+	{
+		return (iOffset + 7) & ~7;
+	}
+}
+
+void FAttackRecord::Make(const FAttackEntry& oEntry, FAttackRecord& oRecord)
+{
+	FMemory::Memzero(oRecord);
+
+	oRecord.fPlayRate = oEntry.fPlayRate;
+	oRecord.fMaxCharge = oEntry.fMaxCharge;
+	oRecord.fEndComboWait = oEntry.fEndComboWait;
+	oRecord.fMoveControlFactor = oEntry.fMoveControlFactor;
+	oRecord.fTurnControlFactor = oEntry.fTurnControlFactor;
+
+	oRecord.iAIResponse = oEntry.iAIAppropsResponse;
+	oRecord.iAnimPath = INDEX_NONE;
+	oRecord.iId = INDEX_NONE;
+
+	oRecord.iBodyPose = (uint8)oEntry.eBodyPose;
+	oRecord.iFlags = (oEntry.bAllowJump ? AllowJump : 0) | (oEntry.bRangeScalesMovement ? RangeScalesMovement : 0);
+}
+
+bool FAttackRecord::SameData(const FAttackRecord& oOther) const
+{
+	return fPlayRate == oOther.fPlayRate && fMaxCharge == oOther.fMaxCharge && fEndComboWait == oOther.fEndComboWait
+		&& fMoveControlFactor == oOther.fMoveControlFactor && fTurnControlFactor == oOther.fTurnControlFactor
+		&& iAIResponse == oOther.iAIResponse && iBodyPose == oOther.iBodyPose && iFlags == oOther.iFlags;
+}
+
+FAttackDataBlob::FAttackDataBlob()
+{
+	poHeader = nullptr;
+	poRecords = nullptr;
+	pcStrings = nullptr;
+}
+
+const FAttackDataBlob* FAttackDataBlob::Get()
+{
+	if (!bAttackDataLoaded)
+	{
+		bAttackDataLoaded = true;
+
+		TArray<uint8> aiFile;
+
+		if (FFileHelper::LoadFileToArray(aiFile, *GetCookedPath(), FILEREAD_Silent))
+		{
+			GAttackData = MakeShareable(new FAttackDataBlob());
+
+			if (!GAttackData->Load(aiFile))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Attack data %s is not valid, cook it again with HNS.CookAttackData"), *GetCookedPath());
+				GAttackData.Reset();
+			}
+		}
+	}
+
+	return GAttackData.Get();
+}
+
+const FAttackRecord* FAttackDataBlob::FindRecord(FAttackEntry* poAttack)
+{
+	const FAttackDataBlob* poBlob = Get();
+
+	if (!poBlob || !poAttack)
+		return nullptr;
+
+	if (const int32* piRecord = poBlob->kResolved.Find(poAttack))
+		return poBlob->GetRecord(*piRecord);
+
+	const FString* psId = FCombatNetDictionaries::Get().FindAttackId(poAttack);
+
+	// not registered yet, try again once its dictionary is
+	if (!psId)
+		return nullptr;
+
+	const int32* piRecord = poBlob->kRecordsById.Find(*psId);
+	int32 iRecord = piRecord ? *piRecord : INDEX_NONE;
+
+#if !UE_BUILD_SHIPPING
+	// checked once per attack instead of every time it starts, an out of date record is left for the entry's own data
+	if (iRecord != INDEX_NONE)
+	{
+		FAttackRecord oEntryRecord;
+		FAttackRecord::Make(*poAttack, oEntryRecord);
+
+		if (!poBlob->GetRecord(iRecord)->SameData(oEntryRecord))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Attack data for %s is out of date, cook it again with HNS.CookAttackData"), **psId);
+			iRecord = INDEX_NONE;
+		}
+	}
+#endif
+
+	poBlob->kResolved.Add(poAttack, iRecord);
+
+	return poBlob->GetRecord(iRecord);
+}
+
+void FAttackDataBlob::Cook(TArray<uint8>& aiBlob)
+{
+	const FCombatNetDictionaries& oDictionaries = FCombatNetDictionaries::Get();
+	const TReplicationDictionary<FAttackEntry>& oAttacks = oDictionaries.oAttacks;
+
+	TArray<FAttackRecord> aoRecords;
+	TArray<TCHAR> acStrings;
+
+	aoRecords.AddUninitialized(oAttacks.Num());
+
+	for (int32 iAttack = 0; iAttack < oAttacks.Num(); iAttack++)
+	{
+		FAttackEntry* poAttack = oAttacks.Get(iAttack);
+		FAttackRecord& oRecord = aoRecords[iAttack];
+
+		FAttackRecord::Make(*poAttack, oRecord);
+
+		if (const FString* psId = oDictionaries.FindAttackId(poAttack))
+		{
+			oRecord.iId = acStrings.Num();
+			acStrings.Append(**psId, psId->Len() + 1);
+		}
+
+		if (poAttack->pkAttackAnim)
+		{
+			FString sPath = poAttack->pkAttackAnim->GetPathName();
+
+			oRecord.iAnimPath = acStrings.Num();
+			acStrings.Append(*sPath, sPath.Len() + 1);
+		}
+	}
+
+	FHeader oHeader;
+
+	oHeader.iMagic = Magic;
+	oHeader.iVersion = Version;
+	oHeader.iNumRecords = aoRecords.Num();
+	oHeader.iRecordsOffset = Align(sizeof(FHeader));
+	oHeader.iStringsOffset = Align(oHeader.iRecordsOffset + aoRecords.Num() * sizeof(FAttackRecord));
+	oHeader.iStringsSize = acStrings.Num() * sizeof(TCHAR);
+
+	aiBlob.Empty(oHeader.iStringsOffset + oHeader.iStringsSize);
+	aiBlob.AddZeroed(oHeader.iStringsOffset + oHeader.iStringsSize);
+
+	FMemory::Memcpy(aiBlob.GetData(), &oHeader, sizeof(FHeader));
+	FMemory::Memcpy(aiBlob.GetData() + oHeader.iRecordsOffset, aoRecords.GetData(), aoRecords.Num() * sizeof(FAttackRecord));
+	FMemory::Memcpy(aiBlob.GetData() + oHeader.iStringsOffset, acStrings.GetData(), oHeader.iStringsSize);
+}
+
+void FAttackDataBlob::CookToFile()
+{
+	TArray<uint8> aiBlob;
+
+	Cook(aiBlob);
+
+	if (!FFileHelper::SaveArrayToFile(aiBlob, *GetCookedPath()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write attack data to %s"), *GetCookedPath());
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Cooked %d attacks into %d bytes at %s"), FCombatNetDictionaries::Get().oAttacks.Num(), aiBlob.Num(), *GetCookedPath());
+
+	// characters keep pointers into the old blob, it is only replaced when nothing has loaded it yet
+	if (!GAttackData.IsValid())
+		bAttackDataLoaded = false;
+}
+
+FString FAttackDataBlob::GetCookedPath()
+{
+	return FPaths::GameContentDir() / TEXT("Data/AttackData.bin");
+}
+
+bool FAttackDataBlob::Load(TArray<uint8>& aiFile)
+{
+	aiBlob = MoveTemp(aiFile);
+
+	poHeader = nullptr;
+	poRecords = nullptr;
+	pcStrings = nullptr;
+
+	kRecordsById.Empty();
+	kResolved.Empty();
+
+	if (aiBlob.Num() < (int32)sizeof(FHeader))
+		return false;
+
+	const FHeader* poFileHeader = (const FHeader*)aiBlob.GetData();
+
+	if (poFileHeader->iMagic != Magic || poFileHeader->iVersion != Version || poFileHeader->iNumRecords < 0)
+		return false;
+
+	// sections must be inside the file
+	if (poFileHeader->iRecordsOffset + (uint64)poFileHeader->iNumRecords * sizeof(FAttackRecord) > (uint64)poFileHeader->iStringsOffset
+		|| poFileHeader->iStringsOffset + (uint64)poFileHeader->iStringsSize > (uint64)aiBlob.Num())
+		return false;
+
+	poHeader = poFileHeader;
+	poRecords = (const FAttackRecord*)(aiBlob.GetData() + poHeader->iRecordsOffset);
+	pcStrings = (const TCHAR*)(aiBlob.GetData() + poHeader->iStringsOffset);
+
+	for (int32 iRecord = 0; iRecord < poHeader->iNumRecords; iRecord++)
+	{
+		const TCHAR* pcId = GetString(poRecords[iRecord].iId);
+
+		if (*pcId)
+			kRecordsById.Add(pcId, iRecord);
+	}
+
+	return true;
+}
+
+const TCHAR* FAttackDataBlob::GetAnimPath(const FAttackRecord& oRecord) const
+{
+	return GetString(oRecord.iAnimPath);
+}
+
+const TCHAR* FAttackDataBlob::GetString(int32 iOffset) const
+{
+	if (iOffset < 0 || (uint32)iOffset * sizeof(TCHAR) >= poHeader->iStringsSize)
+		return TEXT("");
+
+	return pcStrings + iOffset;
+}
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+struct FAttackEntry;
+
+// the scalar attack data read every tick, copied out of the attack entries - no pointers so the blob can be loaded anywhere
+struct FAttackRecord
+{
+	enum EFlags
+	{
+		AllowJump = 1 << 0,
+		RangeScalesMovement = 1 << 1,
+	};
+
+	float fPlayRate;
+	float fMaxCharge;
+	float fEndComboWait;
+	float fMoveControlFactor;
+	float fTurnControlFactor;
+
+	int32 iAIResponse;
+
+	// offset of the attack animation's path in the string table, INDEX_NONE if there is none
+	int32 iAnimPath;
+
+	// offset of the attack's id in the string table, the record is found by it
+	int32 iId;
+
+	uint8 iBodyPose;
+	uint8 iFlags;
+
+	uint8 aiPad[2];
+
+	// copy an attack entry - the strings are left for the cook to fill in
+	static void Make(const FAttackEntry& oEntry, FAttackRecord& oRecord);
+
+	// every value copied from the entry matches, strings are not compared
+	bool SameData(const FAttackRecord& oOther) const;
+};
+
+// attack records of every registered attack, cooked into one flat read-only blob that is loaded once and shared by all characters
+// records are keyed by the attack's id in its dictionary, so they are found no matter what order dictionaries are loaded in
+class HACKNSLACKS_API FAttackDataBlob
+{
+public:
+	static const uint32 Magic = 0x4B544148;
+	static const uint32 Version = 2;
+
+	struct FHeader
+	{
+		uint32 iMagic;
+		uint32 iVersion;
+
+		int32 iNumRecords;
+
+		// offsets from the start of the blob
+		uint32 iRecordsOffset;
+		uint32 iStringsOffset;
+		uint32 iStringsSize;
+	};
+
+	FAttackDataBlob();
+
+	// shared blob, loaded from the cooked file on first use - nullptr if there is no valid file
+	static const FAttackDataBlob* Get();
+
+	// record for a registered attack, nullptr if the attack is not registered or was added after the blob was cooked - outside
+	// shipping builds also nullptr if the entry changed since the cook, checked the first time the attack is looked up
+	static const FAttackRecord* FindRecord(FAttackEntry* poAttack);
+
+	// write the registered attacks into a blob
+	static void Cook(TArray<uint8>& aiBlob);
+
+	// cook the registered attacks to the cooked file and reload it
+	static void CookToFile();
+
+	// cooked file the blob is loaded from
+	static FString GetCookedPath();
+
+	// takes the loaded file, returns false if it is not a valid blob
+	bool Load(TArray<uint8>& aiFile);
+
+	FORCEINLINE int32 Num() const { return poHeader ? poHeader->iNumRecords : 0; }
+
+	FORCEINLINE const FAttackRecord* GetRecord(int32 iIndex) const { return iIndex >= 0 && iIndex < Num() ? &poRecords[iIndex] : nullptr; }
+
+	// path of the record's animation, empty if it has none
+	const TCHAR* GetAnimPath(const FAttackRecord& oRecord) const;
+
+private:
+	const TCHAR* GetString(int32 iOffset) const;
+
+	TArray<uint8> aiBlob;
+
+	// record index by attack id, built on load
+	TMap<FString, int32> kRecordsById;
+
+	// record index by attack, resolved from the id on first lookup - INDEX_NONE if the blob has no record for it
+	mutable TMap<const FAttackEntry*, int32> kResolved;
+
+	// views into the blob
+	const FHeader* poHeader;
+	const FAttackRecord* poRecords;
+	const TCHAR* pcStrings;
+};
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "PerWorld.h"
+#include "AttackEventBuffer.h"
+
+FAttackEventBuffer::FAttackEventBuffer(UWorld* pkWorld)
+{
+	for (FSlot& oSlot : aoSlots)
+		oSlot.iPublished = 0;
+
+	iHead = 0;
+}
+
+FAttackEventBuffer* FAttackEventBuffer::Get(UWorld* pkWorld)
+{
+	return TPerWorld<FAttackEventBuffer>::Get(pkWorld);
+}
+
+void FAttackEventBuffer::Publish(const FAttackEvent& oEvent)
+{
+	// claim a sequence, concurrent publishers get different slots
+	int64 iSequence = FPlatformAtomics::InterlockedIncrement(&iHead) - 1;
+
+	FSlot& oSlot = aoSlots[iSequence % Capacity];
+
+	// mark the slot as being written so readers skip it
+	FPlatformAtomics::InterlockedExchange(&oSlot.iPublished, 0);
+
+	oSlot.oEvent = oEvent;
+
+	FPlatformMisc::MemoryBarrier();
+
+	FPlatformAtomics::InterlockedExchange(&oSlot.iPublished, iSequence + 1);
+}
+
+int32 FAttackEventBuffer::Read(uint64& iCursor, const FVector& oCenter, float fRadius, TArray<FAttackEvent>& aoEvents) const
+{
+	int64 iEnd = iHead;
+
+	// skip events already overwritten
+	int64 iSequence = FMath::Max((int64)iCursor, iEnd - Capacity);
+
+	float fRadiusSquared = FMath::Square(fRadius);
+	int32 iRead = 0;
+
+	for (; iSequence < iEnd; iSequence++)
+	{
+		const FSlot& oSlot = aoSlots[iSequence % Capacity];
+
+		// still being written - stop so it is read next time
+		if (oSlot.iPublished != iSequence + 1)
+		{
+			if (oSlot.iPublished < iSequence + 1)
+				break;
+
+			// overwritten by a newer event
+			continue;
+		}
+
+		FAttackEvent oEvent = oSlot.oEvent;
+
+		FPlatformMisc::MemoryBarrier();
+
+		// overwritten while it was copied
+		if (oSlot.iPublished != iSequence + 1)
+			continue;
+
+		if (FVector::DistSquared(oEvent.oLocation, oCenter) <= fRadiusSquared)
+		{
+			aoEvents.Add(oEvent);
+			iRead++;
+		}
+	}
+
+	iCursor = (uint64)iSequence;
+
+	return iRead;
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "AttackEventBuffer.generated.h"
+
+class AHackNSlacksCharacter;
+struct FAttackEntry;
+
+// an attack that has started, for AI to react to
+USTRUCT(BlueprintType)
+struct FAttackEvent
+{
+	GENERATED_USTRUCT_BODY()
+
+	FAttackEvent() : poAttackEntry(nullptr), iAIResponse(0), oLocation(0.0f), oDirection(0.0f), fStartTime(0.0f), fActiveEndTime(0.0f), bCharging(false) {}
+
+	UPROPERTY(BlueprintReadOnly, Category = AI)
+	TWeakObjectPtr<AHackNSlacksCharacter> pkAttacker;
+
+	const FAttackEntry* poAttackEntry;
+
+	// the attack entry's AI response id
+	UPROPERTY(BlueprintReadOnly, Category = AI)
+	int32 iAIResponse;
+
+	// attacker location when the attack started
+	UPROPERTY(BlueprintReadOnly, Category = AI)
+	FVector oLocation;
+
+	// direction the attack is aimed
+	UPROPERTY(BlueprintReadOnly, Category = AI)
+	FVector oDirection;
+
+	// world time the attack started
+	UPROPERTY(BlueprintReadOnly, Category = AI)
+	float fStartTime;
+
+	// world time the attack animation ends, including the longest charge
+	UPROPERTY(BlueprintReadOnly, Category = AI)
+	float fActiveEndTime;
+
+	UPROPERTY(BlueprintReadOnly, Category = AI)
+	bool bCharging;
+};
+
+// ring of the latest attack events in one world - any thread can publish without a lock, each reader keeps its own cursor
+class HACKNSLACKS_API FAttackEventBuffer
+{
+public:
+	// events older than this many publishes are overwritten
+	static const int32 Capacity = 256;
+
+	FAttackEventBuffer(UWorld* pkWorld);
+
+	// buffer for a world, created on first use and destroyed with the world - game thread only
+	static FAttackEventBuffer* Get(UWorld* pkWorld);
+
+	void Publish(const FAttackEvent& oEvent);
+
+	// copy events published since iCursor within fRadius of oCenter and advance the cursor - events overwritten before they were read are skipped
+	int32 Read(uint64& iCursor, const FVector& oCenter, float fRadius, TArray<FAttackEvent>& aoEvents) const;
+
+	// cursor that skips every event published so far
+	FORCEINLINE uint64 GetHead() const { return (uint64)iHead; }
+
+private:
+	struct FSlot
+	{
+		// sequence of the event in the slot plus one, zero while it is being written
+		volatile int64 iPublished;
+
+		FAttackEvent oEvent;
+	};
+
+	FSlot aoSlots[Capacity];
+
+	// sequence of the next event
+	volatile int64 iHead;
+};
@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HackNSlacksCharacter.h"
+#include "PerWorld.h"
+#include "HNSNames.h"
+#include "AttackHitSystem.h"
+
+FAttackHitSystem::FAttackHitSystem(UWorld* pkInWorld)
+{
+	pkWorld = pkInWorld;
+
+	eChannel = ECC_Pawn;
+
+	iNextSwing = 1;
+}
+
+FAttackHitSystem* FAttackHitSystem::Get(UWorld* pkWorld)
+{
+	return TPerWorld<FAttackHitSystem>::Get(pkWorld);
+}
+
+int32 FAttackHitSystem::BeginSwing(AHackNSlacksCharacter* pkAttacker, EBodyParts eBodyPart, float fRadius)
+{
+	FSwing oSwing;
+
+	oSwing.pkAttacker = pkAttacker;
+	oSwing.fRadius = fRadius;
+	oSwing.iSwing = iNextSwing++;
+	oSwing.eBodyPart = eBodyPart;
+	oSwing.bActive = true;
+
+	// start from where the body part is now so the first sweep does not cover the wind up
+	oSwing.bHasLastLocation = pkAttacker->HasSocket(eBodyPart);
+	oSwing.oLastLocation = pkAttacker->GetSocketTransform(eBodyPart).GetLocation();
+
+	aoSwings.Add(oSwing);
+
+	return oSwing.iSwing;
+}
+
+void FAttackHitSystem::EndSwing(int32 iSwing)
+{
+	if (FSwing* poSwing = FindSwing(iSwing))
+		poSwing->bActive = false;
+}
+
+FAttackHitSystem::FSwing* FAttackHitSystem::FindSwing(int32 iSwing)
+{
+	for (FSwing& oSwing : aoSwings)
+		if (oSwing.iSwing == iSwing)
+			return &oSwing;
+
+	return nullptr;
+}
+
+void FAttackHitSystem::Tick(float DeltaTime)
+{
+	if (!pkWorld.IsValid())
+		return;
+
+	DeliverHits();
+
+	IssueSweeps();
+
+	// ended swings are kept until their last sweep has been delivered
+	for (int32 iSwing = aoSwings.Num() - 1; iSwing >= 0; iSwing--)
+	{
+		const FSwing& oSwing = aoSwings[iSwing];
+
+		if (oSwing.bActive && oSwing.pkAttacker.IsValid())
+			continue;
+
+		bool bPending = false;
+
+		for (const FPendingSweep& oSweep : aoPending)
+			bPending |= oSweep.iSwing == oSwing.iSwing;
+
+		if (!bPending)
+			aoSwings.RemoveAtSwap(iSwing, 1, false);
+	}
+}
+
+void FAttackHitSystem::DeliverHits()
+{
+	UWorld* pkTraceWorld = pkWorld.Get();
+
+	FTraceDatum oDatum;
+
+	// the world double buffers async traces, so last frame's results are only readable this frame - a sweep that is not
+	// ready now is dropped rather than read from a buffer that is about to be reused
+	for (const FPendingSweep& oSweep : aoPending)
+	{
+		if (!pkTraceWorld->QueryTraceData(oSweep.oHandle, oDatum))
+			continue;
+
+		FSwing* poSwing = FindSwing(oSweep.iSwing);
+
+		AHackNSlacksCharacter* pkAttacker = poSwing ? poSwing->pkAttacker.Get() : nullptr;
+
+		if (!pkAttacker || pkAttacker->IsPendingKill())
+			continue;
+
+		for (const FHitResult& oHit : oDatum.OutHits)
+		{
+			AHackNSlacksCharacter* pkVictim = Cast<AHackNSlacksCharacter>(oHit.GetActor());
+
+			// no friendly fire and no hitting the same target twice in one swing
+			if (!pkVictim || pkVictim == pkAttacker || pkVictim->eTeam == pkAttacker->eTeam || pkVictim->IsPendingKill())
+				continue;
+
+			if (poSwing->apkHit.Contains(pkVictim))
+				continue;
+
+			poSwing->apkHit.Add(pkVictim);
+
+			pkAttacker->OnSweptHit(pkVictim, poSwing->eBodyPart, oHit);
+
+			// the hit can end the swing or destroy the attacker
+			if (!(poSwing = FindSwing(oSweep.iSwing)) || pkAttacker->IsPendingKill())
+				break;
+		}
+	}
+
+	aoPending.Reset();
+}
+
+void FAttackHitSystem::IssueSweeps()
+{
+	UWorld* pkTraceWorld = pkWorld.Get();
+
+	for (FSwing& oSwing : aoSwings)
+	{
+		AHackNSlacksCharacter* pkAttacker = oSwing.pkAttacker.Get();
+
+		if (!oSwing.bActive || !pkAttacker || !pkAttacker->HasSocket(oSwing.eBodyPart))
+			continue;
+
+		// cached after the attacker's mesh animated this frame
+		const FVector oLocation = pkAttacker->GetSocketTransform(oSwing.eBodyPart).GetLocation();
+
+		if (oSwing.bHasLastLocation)
+		{
+			FCollisionQueryParams oParams(FHNSNames::AttackSweep, false, pkAttacker);
+
+			FPendingSweep oSweep;
+
+			// an object type query returns every body it passes, a channel query would stop at the first pawn that blocks it
+			oSweep.oHandle = pkTraceWorld->AsyncSweepByObjectType(EAsyncTraceType::Multi, oSwing.oLastLocation, oLocation, FCollisionObjectQueryParams(eChannel), FCollisionShape::MakeSphere(oSwing.fRadius), oParams);
+			oSweep.iSwing = oSwing.iSwing;
+
+			aoPending.Add(oSweep);
+		}
+
+		oSwing.oLastLocation = oLocation;
+		oSwing.bHasLastLocation = true;
+	}
+}
+
+bool FAttackHitSystem::IsTickable() const
+{
+	return aoSwings.Num() > 0 || aoPending.Num() > 0;
+}
+
+TStatId FAttackHitSystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FAttackHitSystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BodySocket.h"
+#include "Tickable.h"
+
+class AHackNSlacksCharacter;
+
+// sweeps active attack body parts from where they were last frame to where they are now - all sweeps for a frame are
+// issued as one async batch and their hits delivered to the attacker the next frame, so fast swings cannot pass through targets
+class HACKNSLACKS_API FAttackHitSystem : public FTickableGameObject
+{
+public:
+	FAttackHitSystem(UWorld* pkWorld);
+
+	// hit system for a world, created on first use and destroyed with the world - game thread only
+	static FAttackHitSystem* Get(UWorld* pkWorld);
+
+	// start sweeping a body part - each swing hits a target at most once, returns the swing handle
+	int32 BeginSwing(AHackNSlacksCharacter* pkAttacker, EBodyParts eBodyPart, float fRadius);
+
+	// stop sweeping - hits from the last sweep are still delivered
+	void EndSwing(int32 iSwing);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	// object type swept against, no body of the type blocks the sweep
+	ECollisionChannel eChannel;
+
+private:
+	struct FSwing
+	{
+		TWeakObjectPtr<AHackNSlacksCharacter> pkAttacker;
+
+		// targets already hit by this swing
+		TArray<TWeakObjectPtr<AActor>, TInlineAllocator<4>> apkHit;
+
+		FVector oLastLocation;
+
+		float fRadius;
+
+		int32 iSwing;
+
+		EBodyParts eBodyPart;
+
+		bool bHasLastLocation;
+
+		bool bActive;
+	};
+
+	struct FPendingSweep
+	{
+		FTraceHandle oHandle;
+
+		int32 iSwing;
+	};
+
+	// hand last frame's sweep results to their attackers - every pending sweep is consumed or dropped
+	void DeliverHits();
+
+	// sweep every active swing from last frame's location to this frame's
+	void IssueSweeps();
+
+	FSwing* FindSwing(int32 iSwing);
+
+	TWeakObjectPtr<UWorld> pkWorld;
+
+	TArray<FSwing> aoSwings;
+
+	TArray<FPendingSweep> aoPending;
+
+	int32 iNextSwing;
+};
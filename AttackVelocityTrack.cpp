@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "AttackEntry.h"
+#include "CombatReplication.h"
+#include "AttackVelocityTrack.h"
+
+namespace
+{
+	// baked tracks by animation, a null track marks an animation without root motion
+	TMap<TWeakObjectPtr<const UAnimSequenceBase>, TSharedPtr<FAttackVelocityTrack>> GAttackVelocityTracks;
+
+	// dictionaries whose attacks are already baked
+	TSet<TWeakObjectPtr<UAttackDictionary>> GBakedDictionaries;
+
+	// root motion smaller than this per second is treated as none
+	const float MinRootSpeed = 1.0f;
+}
+
+const float FAttackVelocityTrack::SampleRate = 30.0f;
+
+FAttackVelocityTrack::FAttackVelocityTrack()
+{
+	fLength = 0.0f;
+	bMovesVertically = false;
+}
+
+bool FAttackVelocityTrack::Bake(const UAnimSequenceBase* pkAnim)
+{
+	aoVelocities.Reset();
+	fLength = 0.0f;
+	bMovesVertically = false;
+
+	// montages and composites are not baked, they fall back to the anim instance
+	const UAnimSequence* pkSequence = Cast<const UAnimSequence>(pkAnim);
+
+	if (!pkSequence || pkSequence->SequenceLength <= 0.0f)
+		return false;
+
+	fLength = pkSequence->SequenceLength;
+
+	int32 iNumSamples = FMath::CeilToInt(fLength * SampleRate);
+	float fInterval = 1.0f / SampleRate;
+
+	aoVelocities.Reserve(iNumSamples);
+
+	bool bMoves = false;
+
+	for (int32 iSample = 0; iSample < iNumSamples; iSample++)
+	{
+		float fStart = iSample * fInterval;
+		float fDelta = FMath::Min(fInterval, fLength - fStart);
+
+		FVector oVelocity = fDelta > 0.0f ? pkSequence->ExtractRootMotion(fStart, fDelta, false).GetTranslation() / fDelta : FVector::ZeroVector;
+
+		bMoves |= oVelocity.SizeSquared() > FMath::Square(MinRootSpeed);
+		bMovesVertically |= FMath::Abs(oVelocity.Z) > MinRootSpeed;
+
+		aoVelocities.Add(oVelocity);
+	}
+
+	if (!bMoves)
+	{
+		aoVelocities.Empty();
+		return false;
+	}
+
+	return true;
+}
+
+FVector FAttackVelocityTrack::Evaluate(const FVector& oLocalVelocity, float fAnimTime, float fPlayRate) const
+{
+	FVector oVelocity = FVector::ZeroVector;
+
+	// no root motion after the animation ends
+	if (fAnimTime >= 0.0f && fAnimTime < fLength)
+	{
+		float fSample = fAnimTime * SampleRate;
+		int32 iSample = FMath::Min(FMath::FloorToInt(fSample), aoVelocities.Num() - 1);
+		int32 iNextSample = FMath::Min(iSample + 1, aoVelocities.Num() - 1);
+
+		oVelocity = FMath::Lerp(aoVelocities[iSample], aoVelocities[iNextSample], fSample - iSample) * fPlayRate;
+	}
+
+	if (!bMovesVertically)
+		oVelocity.Z = oLocalVelocity.Z;
+
+	return oVelocity;
+}
+
+const FAttackVelocityTrack* FAttackVelocityTrack::FindOrBake(const FAttackEntry* poAttackEntry)
+{
+	if (!poAttackEntry || !poAttackEntry->pkAttackAnim)
+		return nullptr;
+
+	TWeakObjectPtr<const UAnimSequenceBase> pkAnim = poAttackEntry->pkAttackAnim;
+
+	if (const TSharedPtr<FAttackVelocityTrack>* poTrack = GAttackVelocityTracks.Find(pkAnim))
+		return poTrack->Get();
+
+	TSharedPtr<FAttackVelocityTrack> poTrack = MakeShareable(new FAttackVelocityTrack());
+
+	if (!poTrack->Bake(pkAnim.Get()))
+		poTrack.Reset();
+
+	GAttackVelocityTracks.Add(pkAnim, poTrack);
+
+	return poTrack.Get();
+}
+
+void FAttackVelocityTrack::BakeDictionary(UAttackDictionary* pkDict)
+{
+	if (!pkDict || GBakedDictionaries.Contains(pkDict))
+		return;
+
+	GBakedDictionaries.Add(pkDict);
+
+	TArray<FAttackDictionaryEntry> aoEntries;
+	FCombatNetDictionaries::CollectAttacks(pkDict, aoEntries);
+
+	for (const FAttackDictionaryEntry& oEntry : aoEntries)
+		FindOrBake(oEntry.poEntry);
+}
+
+void FAttackVelocityTrack::EmptyCache()
+{
+	GAttackVelocityTracks.Empty();
+	GBakedDictionaries.Empty();
+}
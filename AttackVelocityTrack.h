@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class UAnimSequenceBase;
+class UAttackDictionary;
+struct FAttackEntry;
+
+// an attack animation's root motion baked into mesh space velocity samples, so attack movement is a table lookup instead of an anim instance query
+struct HACKNSLACKS_API FAttackVelocityTrack
+{
+	// samples per second of animation time
+	static const float SampleRate;
+
+	FAttackVelocityTrack();
+
+	// sample the animation's root motion - returns false if it has none
+	bool Bake(const UAnimSequenceBase* pkAnim);
+
+	// velocity at an animation time in mesh space, Z keeps oLocalVelocity's when the root does not move vertically
+	// plain data only, safe to call off the game thread
+	FVector Evaluate(const FVector& oLocalVelocity, float fAnimTime, float fPlayRate) const;
+
+	// baked track for the attack's animation, baking it on first use - nullptr when the animation has no root motion, game thread only
+	static const FAttackVelocityTrack* FindOrBake(const FAttackEntry* poAttackEntry);
+
+	// bake every attack in the dictionary, call as it is loaded so no attack bakes mid-combo - game thread only
+	static void BakeDictionary(UAttackDictionary* pkDict);
+
+	// drop every baked track, used when animations are reimported
+	static void EmptyCache();
+
+	// velocity over each sample interval at a play rate of 1
+	TArray<FVector> aoVelocities;
+
+	// animation length in seconds
+	float fLength;
+
+	// the root moves up or down - otherwise vertical velocity is left to the movement component
+	bool bMovesVertically;
+};
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HNSNames.h"
+#include "AngleMath.h"
+#include "CameraFollowComponent.h"
+
+UCameraFollowComponent::UCameraFollowComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	// FollowCamera Default Values
+	fCameraRotRate = 0.6f;
+	fAngleInfluence = 5.0f;
+
+	aClosestActorInView = nullptr;
+	bIsLockedOn = false;
+	bDisableAutoCameraFollow = false;
+}
+
+void UCameraFollowComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	APawn* pkPawn = Cast<APawn>(GetOwner());
+
+	if (!pkPawn || bIsLockedOn || bDisableAutoCameraFollow)
+		return;
+
+	FRotator PlayerRotator = pkPawn->GetControlRotation();
+	FRotator TempYawRotator;
+
+	// Getting Yaw as that is the only axis to rotate
+	TempYawRotator.Yaw = PlayerRotator.Yaw; TempYawRotator.Pitch = 0; TempYawRotator.Roll = 0;
+
+	FVector ForwardVector = FRotationMatrix(TempYawRotator).GetUnitAxis(EAxis::X) * pkPawn->GetInputAxisValue(FHNSNames::MoveForward);
+	FVector RightVector = FRotationMatrix(TempYawRotator).GetUnitAxis(EAxis::Y) * pkPawn->GetInputAxisValue(FHNSNames::MoveRight);
+
+	FVector MoveDirection = ForwardVector + RightVector;
+	MoveDirection.Normalize();
+
+	/*DeltaYaw is MoveDirections yaw - Controllers yaw then normalised*/
+	float DeltaYaw = FAngleMath::WrapDegrees(FAngleMath::YawDegrees(MoveDirection) - PlayerRotator.Yaw);
+
+	float InputLength = FMath::Abs(pkPawn->GetInputAxisValue(FHNSNames::MoveForward)) + FMath::Abs(pkPawn->GetInputAxisValue(FHNSNames::MoveRight));
+	FMath::Clamp(InputLength, 0.f, 1.0f);
+
+	FVector ControllerForwardVec = FRotationMatrix(TempYawRotator).GetUnitAxis(EAxis::X);
+
+	float CameraMoveDotProd = FVector::DotProduct(ControllerForwardVec, MoveDirection);
+
+	CameraMoveDotProd = 1 - FMath::Abs(CameraMoveDotProd);
+
+	float FirstStep = InputLength * DeltaTime * FMath::Pow(CameraMoveDotProd, fAngleInfluence) * fCameraRotRate;
+	FMath::Clamp(FirstStep, 0.f, 1.0f);
+	pkPawn->AddControllerYawInput(FirstStep * DeltaYaw);
+}
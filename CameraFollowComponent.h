@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "CameraFollowComponent.generated.h"
+
+// turns the controller towards the owner's movement direction and holds lock-on state - only player controlled characters have one
+UCLASS(ClassGroup = Camera, meta = (BlueprintSpawnableComponent))
+class HACKNSLACKS_API UCameraFollowComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCameraFollowComponent(const FObjectInitializer& ObjectInitializer);
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	//FollowCam
+	/* Float that changes when the camera starts to rotate to follow the players facing direction */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CameraAdjustments)
+	float fAngleInfluence;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CameraAdjustments)
+	float fCameraRotRate;
+
+	//LockCam
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = CameraAdjustments)
+	AActor* aClosestActorInView;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lock-On")
+	bool bIsLockedOn;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lock-On")
+	bool bDisableAutoCameraFollow;
+};
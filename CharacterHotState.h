@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+struct FAttackEntry;
+struct FAttackRecord;
+
+// combat and movement state read or written every tick, kept together on one cache line
+MS_ALIGN(PLATFORM_CACHE_LINE_SIZE) struct FCharacterHotState
+{
+	FCharacterHotState()
+		: poCurrentAttack(nullptr), poCurrentRecord(nullptr), oDodgeDir(FVector::ZeroVector), fComboTimer(0.0f), fChargeTimer(0.0f), fDodgeLockTimer(0.0f), fCombatAccumulator(0.0f), iDodgeCount(0),
+		bCharging(false), bDodging(false), bOnGround(true), bSprinting(false), bReplayingPrediction(false)
+	{}
+
+	// current attack the character is performing
+	FAttackEntry* poCurrentAttack;
+
+	// flat copy of the current attack's tick data, set whenever poCurrentAttack is
+	const FAttackRecord* poCurrentRecord;
+
+	// direction the character is dodging
+	FVector oDodgeDir;
+
+	// combo input timer, time into the current attack at its play rate - the attack animation is at fComboTimer * fPlayRate,
+	// a released charge starts it where the charge left the animation
+	float fComboTimer;
+
+	// charge attack timer
+	float fChargeTimer;
+
+	// how long the character has been unable to move after dodging
+	float fDodgeLockTimer;
+
+	// frame time not yet run as a fixed combat step
+	float fCombatAccumulator;
+
+	// how many times the character has dodged recently
+	int32 iDodgeCount;
+
+	// if the character is charging an attack
+	bool bCharging;
+
+	// the character is dodging
+	bool bDodging;
+
+	// the character is on the ground
+	bool bOnGround;
+
+	// the character is sprinting
+	bool bSprinting;
+
+	// predicted frames are being replayed after a server correction - attacks only update state, no effects or animation
+	bool bReplayingPrediction;
+} GCC_ALIGN(PLATFORM_CACHE_LINE_SIZE);
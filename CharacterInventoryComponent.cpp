@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "Item.h"
+#include "Chest.h"
+#include "CharacterInventoryComponent.h"
+
+UCharacterInventoryComponent::UCharacterInventoryComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	pkClosestItem = nullptr;
+}
+
+void UCharacterInventoryComponent::AddNearbyItem(AItem* pkNearbyItem)
+{
+	if (!apkNearbyItems.FindNode(pkNearbyItem))
+		apkNearbyItems.AddTail(pkNearbyItem);
+}
+
+bool UCharacterInventoryComponent::RemoveNearbyItem(AItem* pkNearbyItem)
+{
+	apkNearbyItems.RemoveNode(pkNearbyItem);
+
+	return pkNearbyItem == pkClosestItem;
+}
+
+void UCharacterInventoryComponent::AddNearbyChest(AChest* pkNearbyChest)
+{
+	if (!apkNearbyChests.FindNode(pkNearbyChest))
+		apkNearbyChests.AddTail(pkNearbyChest);
+}
+
+void UCharacterInventoryComponent::RemoveNearbyChest(AChest* pkNearbyChest)
+{
+	apkNearbyChests.RemoveNode(pkNearbyChest);
+}
+
+void UCharacterInventoryComponent::UpdateClosestItem(const FVector& oLocation)
+{
+	pkClosestItem = nullptr;
+
+	if (apkNearbyItems.Num() == 0)
+		return;
+
+	auto pkItemIter = apkNearbyItems.GetHead();
+
+	pkClosestItem = ((pkItemIter->GetValue()!= NULL)?pkItemIter->GetValue():nullptr);
+
+	if (pkClosestItem == nullptr || !pkClosestItem->IsValidLowLevel()) return;
+
+	float fClosestDistSQ = FVector::DistSquared(pkClosestItem->GetActorLocation(), oLocation);
+
+	while ((pkItemIter = pkItemIter->GetNextNode()) != nullptr)
+	{
+		AItem* pkItem = pkItemIter->GetValue();
+
+		float fDistSQ = FVector::DistSquared(pkItem->GetActorLocation(), oLocation);
+
+		if (fDistSQ < fClosestDistSQ)
+		{
+			pkClosestItem = pkItem;
+			fClosestDistSQ = fDistSQ;
+		}
+	}
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "EquipSlots.h"
+#include "BodySocket.h"
+#include "InventoryRecord.h"
+#include "CombatMemory.h"
+#include "Components/ActorComponent.h"
+#include "CharacterInventoryComponent.generated.h"
+
+class AItem;
+class AGear;
+class AChest;
+
+// items, chests and gear a character can interact with - characters that never pick anything up do not have one
+UCLASS(ClassGroup = Item, meta = (BlueprintSpawnableComponent))
+class HACKNSLACKS_API UCharacterInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCharacterInventoryComponent(const FObjectInitializer& ObjectInitializer);
+
+	void AddNearbyItem(AItem* pkItem);
+
+	// returns true if the item was the closest item
+	bool RemoveNearbyItem(AItem* pkItem);
+
+	void AddNearbyChest(AChest* pkChest);
+
+	void RemoveNearbyChest(AChest* pkChest);
+
+	// find the nearby item closest to a location
+	void UpdateClosestItem(const FVector& oLocation);
+
+	// the closest item to the character
+	UPROPERTY(BlueprintReadOnly, Category = Item)
+	AItem* pkClosestItem;
+
+	// items the character is carrying, stored as records rather than live actors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Item)
+	FInventory oInventory;
+
+	TTrackedSize<ECombatMemTag::Inventory> oRecordsMemory;
+
+	// list of items the character is close enough to pick up
+	TTrackedList<AItem*, ECombatMemTag::NearbyItems> apkNearbyItems;
+
+	TTrackedList<AChest*, ECombatMemTag::NearbyChests> apkNearbyChests;
+};
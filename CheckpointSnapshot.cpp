@@ -0,0 +1,387 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "BuffDef.h"
+#include "Weapon.h"
+#include "Enemy.h"
+#include "CharacterInventoryComponent.h"
+#include "HacknSlacksPlayer.h"
+#include "CheckpointSnapshot.h"
+
+namespace
+{
+	// classes are written once into a table and referenced by index
+	struct FClassTable
+	{
+		TArray<FString> asPaths;
+
+		TArray<TWeakObjectPtr<UClass>> apkClasses;
+
+		int32 Add(UClass* pkClass)
+		{
+			if (!pkClass)
+				return INDEX_NONE;
+
+			int32 iIndex = apkClasses.AddUnique(pkClass);
+
+			if (iIndex == asPaths.Num())
+				asPaths.Add(pkClass->GetPathName());
+
+			return iIndex;
+		}
+	};
+
+	// writes happen on a worker, the newest snapshot wins if several are in flight
+	FCriticalSection GSaveLock;
+	FThreadSafeCounter GSaveSequence;
+	int32 GSavedSequence = 0;
+
+	class FSaveSnapshotTask : public FNonAbandonableTask
+	{
+	public:
+		FSaveSnapshotTask(const TArray<uint8>& aiInData, const FString& sInPath, int32 iInSequence)
+			: aiData(aiInData), sPath(sInPath), iSequence(iInSequence)
+		{
+		}
+
+		void DoWork()
+		{
+			FScopeLock oLock(&GSaveLock);
+
+			if (iSequence < GSavedSequence)
+				return;
+
+			// write next to the file and move it over, so a crash mid write keeps the previous snapshot
+			FString sTempPath = sPath + TEXT(".tmp");
+
+			if (FFileHelper::SaveArrayToFile(aiData, *sTempPath) && IFileManager::Get().Move(*sPath, *sTempPath, true))
+				GSavedSequence = iSequence;
+			else
+				UE_LOG(LogTemp, Warning, TEXT("Could not write checkpoint to %s"), *sPath);
+		}
+
+		FORCEINLINE TStatId GetStatId() const
+		{
+			RETURN_QUICK_DECLARE_CYCLE_STAT(FSaveSnapshotTask, STATGROUP_ThreadPoolAsyncTasks);
+		}
+
+	private:
+		TArray<uint8> aiData;
+		FString sPath;
+		int32 iSequence;
+	};
+
+	struct FBuffState
+	{
+		int32 iClass;
+		float fIntensity;
+		float fDuration;
+		float fTimer;
+		int32 iTickCount;
+
+		friend FArchive& operator<<(FArchive& Ar, FBuffState& oState)
+		{
+			return Ar << oState.iClass << oState.fIntensity << oState.fDuration << oState.fTimer << oState.iTickCount;
+		}
+	};
+
+	struct FInventoryState
+	{
+		int32 iClass;
+		int32 iCount;
+
+		friend FArchive& operator<<(FArchive& Ar, FInventoryState& oState)
+		{
+			return Ar << oState.iClass << oState.iCount;
+		}
+	};
+
+	struct FEnemyState
+	{
+		int32 iClass;
+		FName sName;
+		FTransform oTransform;
+		float fHealth;
+
+		friend FArchive& operator<<(FArchive& Ar, FEnemyState& oState)
+		{
+			return Ar << oState.iClass << oState.sName << oState.oTransform << oState.fHealth;
+		}
+	};
+
+	struct FPlayerState
+	{
+		FTransform oTransform;
+		float fHealth;
+		int32 iLives;
+		int32 iTokens;
+		int32 iCrystals;
+		int32 iEquippedSheath;
+
+		TArray<FBuffState> aoBuffs;
+		TArray<FInventoryState> aoInventory;
+
+		friend FArchive& operator<<(FArchive& Ar, FPlayerState& oState)
+		{
+			return Ar << oState.oTransform << oState.fHealth << oState.iLives << oState.iTokens << oState.iCrystals << oState.iEquippedSheath << oState.aoBuffs << oState.aoInventory;
+		}
+	};
+
+	bool ReadHeader(FArchive& Ar)
+	{
+		uint32 iMagic = 0;
+		uint32 iVersion = 0;
+
+		Ar << iMagic << iVersion;
+
+		return !Ar.IsError() && iMagic == FCheckpointSnapshot::Magic && iVersion == FCheckpointSnapshot::Version;
+	}
+}
+
+void FCheckpointSnapshot::Capture(AHacknSlacksPlayer* pkPlayer)
+{
+	aiData.Reset();
+
+	if (!pkPlayer)
+		return;
+
+	FClassTable oClasses;
+	FPlayerState oPlayer;
+
+	oPlayer.oTransform = pkPlayer->oLastCheckpoint.ContainsNaN() ? pkPlayer->GetActorTransform() : pkPlayer->oLastCheckpoint;
+	oPlayer.fHealth = pkPlayer->fHealth;
+	oPlayer.iLives = pkPlayer->iLives;
+	oPlayer.iTokens = pkPlayer->iTokens;
+	oPlayer.iCrystals = pkPlayer->iCrystals;
+	oPlayer.iEquippedSheath = pkPlayer->pkWeapon ? (int32)pkPlayer->pkWeapon->eSheath : INDEX_NONE;
+
+	for (const FBuff& oBuff : pkPlayer->aoBuffs)
+	{
+		if (oBuff.bActive && oBuff.pkBuffDef)
+		{
+			FBuffState oState;
+			oState.iClass = oClasses.Add(oBuff.pkBuffDef->GetClass());
+			oState.fIntensity = oBuff.fIntensity;
+			oState.fDuration = oBuff.fDuration;
+			oState.fTimer = oBuff.fTimer;
+			oState.iTickCount = oBuff.iTickCount;
+
+			oPlayer.aoBuffs.Add(oState);
+		}
+	}
+
+	if (UCharacterInventoryComponent* pkInventory = pkPlayer->GetInventory())
+	{
+		const FInventory& oInventory = pkInventory->oInventory;
+
+		for (int32 iRecord = 0; iRecord < oInventory.aoRecords.Num(); iRecord++)
+		{
+			if (oInventory.IsValidRecord(iRecord))
+			{
+				FInventoryState oState;
+				oState.iClass = oClasses.Add(oInventory.GetRecord(iRecord).pkItemClass);
+				oState.iCount = oInventory.GetRecord(iRecord).iCount;
+
+				oPlayer.aoInventory.Add(oState);
+			}
+		}
+	}
+
+	TArray<FEnemyState> aoEnemies;
+
+	for (TActorIterator<AEnemy> pkEnemyIter(pkPlayer->GetWorld()); pkEnemyIter; ++pkEnemyIter)
+	{
+		AEnemy* pkEnemy = *pkEnemyIter;
+
+		if (pkEnemy->IsPendingKill() || pkEnemy->fHealth <= 0.0f || pkEnemy->IsDying())
+			continue;
+
+		FEnemyState oState;
+		oState.iClass = oClasses.Add(pkEnemy->GetClass());
+		oState.sName = pkEnemy->GetFName();
+		oState.oTransform = pkEnemy->GetActorTransform();
+		oState.fHealth = pkEnemy->fHealth;
+
+		aoEnemies.Add(oState);
+	}
+
+	FMemoryWriter oWriter(aiData);
+
+	uint32 iMagic = Magic;
+	uint32 iVersion = Version;
+
+	oWriter << iMagic << iVersion << oClasses.asPaths << oPlayer << aoEnemies;
+
+	apkClasses = oClasses.apkClasses;
+}
+
+bool FCheckpointSnapshot::Restore(AHacknSlacksPlayer* pkPlayer, bool bRestoreLives) const
+{
+	if (!pkPlayer || !IsValid())
+		return false;
+
+	FMemoryReader oReader(aiData);
+
+	TArray<FString> asClasses;
+	FPlayerState oPlayer;
+	TArray<FEnemyState> aoEnemies;
+
+	ReadHeader(oReader);
+	oReader << asClasses << oPlayer << aoEnemies;
+
+	if (oReader.IsError())
+		return false;
+
+	// PLAYER
+
+	pkPlayer->ResetCombo();
+	pkPlayer->SetDodging(false);
+	pkPlayer->GetCharacterMovement()->Velocity = FVector::ZeroVector;
+	pkPlayer->SetActorTransform(oPlayer.oTransform);
+
+	pkPlayer->fHealth = oPlayer.fHealth;
+	pkPlayer->iTokens = oPlayer.iTokens;
+	pkPlayer->iCrystals = oPlayer.iCrystals;
+
+	if (bRestoreLives)
+		pkPlayer->iLives = oPlayer.iLives;
+
+	if (oPlayer.iEquippedSheath != INDEX_NONE)
+		pkPlayer->SetWeapon((ESheaths)oPlayer.iEquippedSheath);
+
+	// empty the buff bar, highest slot first so the slots do not shift
+	for (int32 iSlot = pkPlayer->iActiveBuffs - 1; iSlot >= 0; iSlot--)
+		pkPlayer->oUIEvents.BuffSlotRemoved(iSlot, iSlot + 1);
+
+	for (FBuff& oBuff : pkPlayer->aoBuffs)
+		oBuff.iIndex = -1;
+
+	// clears every buff - OnDeath would also queue the player's death
+	pkPlayer->StopBuffs();
+	pkPlayer->iActiveBuffs = 0;
+
+	for (const FBuffState& oState : oPlayer.aoBuffs)
+	{
+		if (UClass* pkBuffClass = FindClass(asClasses, oState.iClass))
+		{
+			FBuff& oBuff = pkPlayer->AddBuff(pkBuffClass, oState.fIntensity, oState.fDuration, oState.iTickCount);
+			oBuff.fTimer = oState.fTimer;
+		}
+	}
+
+	if (UCharacterInventoryComponent* pkInventory = pkPlayer->GetInventory())
+	{
+		pkInventory->oInventory.Empty();
+
+		for (const FInventoryState& oState : oPlayer.aoInventory)
+			pkInventory->oInventory.Add(FindClass(asClasses, oState.iClass), oState.iCount);
+	}
+
+	pkPlayer->UpdateFX();
+
+	// LEVEL
+
+	UWorld* pkWorld = pkPlayer->GetWorld();
+
+	TMap<FName, AEnemy*> kLiveEnemies;
+
+	for (TActorIterator<AEnemy> pkEnemyIter(pkWorld); pkEnemyIter; ++pkEnemyIter)
+		if (!pkEnemyIter->IsPendingKill())
+			kLiveEnemies.Add(pkEnemyIter->GetFName(), *pkEnemyIter);
+
+	for (const FEnemyState& oState : aoEnemies)
+	{
+		AEnemy* pkEnemy = nullptr;
+
+		if (AEnemy** ppkEnemy = kLiveEnemies.Find(oState.sName))
+		{
+			pkEnemy = *ppkEnemy;
+			kLiveEnemies.Remove(oState.sName);
+
+			// killed since the checkpoint but not destroyed yet
+			pkEnemy->Revive();
+
+			pkEnemy->ResetCombo();
+			pkEnemy->SetActorTransform(oState.oTransform);
+		}
+		// enemy was killed since the checkpoint
+		else if (UClass* pkEnemyClass = FindClass(asClasses, oState.iClass))
+		{
+			FActorSpawnParameters oParams;
+			oParams.bNoCollisionFail = true;
+
+			// keep the name so the next restore finds this enemy again, unless a destroyed actor still holds it
+			if (!StaticFindObjectFast(nullptr, pkWorld->GetCurrentLevel(), oState.sName))
+				oParams.Name = oState.sName;
+
+			pkEnemy = pkWorld->SpawnActor<AEnemy>(pkEnemyClass, oState.oTransform, oParams);
+		}
+
+		if (pkEnemy)
+			pkEnemy->fHealth = oState.fHealth;
+	}
+
+	// enemies that appeared after the checkpoint
+	for (auto& kEnemy : kLiveEnemies)
+		kEnemy.Value->Destroy();
+
+	return true;
+}
+
+bool FCheckpointSnapshot::SaveToFile(const FString& sPath) const
+{
+	if (!IsValid())
+		return false;
+
+	(new FAutoDeleteAsyncTask<FSaveSnapshotTask>(aiData, sPath, GSaveSequence.Increment()))->StartBackgroundTask();
+
+	return true;
+}
+
+bool FCheckpointSnapshot::LoadFromFile(const FString& sPath)
+{
+	apkClasses.Reset();
+
+	if (!FFileHelper::LoadFileToArray(aiData, *sPath, FILEREAD_Silent) || !IsValid())
+	{
+		aiData.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+UClass* FCheckpointSnapshot::FindClass(const TArray<FString>& asPaths, int32 iIndex) const
+{
+	if (!asPaths.IsValidIndex(iIndex))
+		return nullptr;
+
+	if (apkClasses.Num() < asPaths.Num())
+		apkClasses.SetNum(asPaths.Num());
+
+	UClass* pkClass = apkClasses[iIndex].Get();
+
+	// only loaded the first time the class is needed, or again if it was unloaded
+	if (!pkClass)
+	{
+		pkClass = LoadObject<UClass>(nullptr, *asPaths[iIndex]);
+		apkClasses[iIndex] = pkClass;
+	}
+
+	return pkClass;
+}
+
+bool FCheckpointSnapshot::IsValid() const
+{
+	if (aiData.Num() == 0)
+		return false;
+
+	FMemoryReader oReader(aiData);
+
+	return ReadHeader(oReader);
+}
+
+FString FCheckpointSnapshot::GetDefaultPath()
+{
+	return FPaths::GameSavedDir() / TEXT("Checkpoint.bin");
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AHacknSlacksPlayer;
+
+// versioned binary snapshot of the player's and level's combat state, captured at checkpoints so respawning does not reload the level
+struct HACKNSLACKS_API FCheckpointSnapshot
+{
+	// 'HNSC'
+	static const uint32 Magic = 0x484E5343;
+
+	// bump when the layout written by Capture changes, older snapshots are rejected
+	static const uint32 Version = 2;
+
+	// write the player, their inventory and buffs, and every enemy in the level into the snapshot
+	void Capture(AHacknSlacksPlayer* pkPlayer);
+
+	// put the player and level back to the captured state - lives are only restored when resuming from disk
+	bool Restore(AHacknSlacksPlayer* pkPlayer, bool bRestoreLives) const;
+
+	// write the snapshot as a single flat file on a worker thread - returns false if there is nothing to write
+	bool SaveToFile(const FString& sPath) const;
+
+	// read a snapshot written by SaveToFile with one read - returns false if it is missing or from another version
+	bool LoadFromFile(const FString& sPath);
+
+	bool IsValid() const;
+
+	void Reset() { aiData.Reset(); apkClasses.Reset(); }
+
+	// default location for the crash resume file
+	static FString GetDefaultPath();
+
+private:
+	// class in the path table, loaded once and cached
+	UClass* FindClass(const TArray<FString>& asPaths, int32 iIndex) const;
+
+	// header followed by the class path table and the state blocks
+	TArray<uint8> aiData;
+
+	// classes of the path table, captured or loaded on first restore
+	mutable TArray<TWeakObjectPtr<UClass>> apkClasses;
+};
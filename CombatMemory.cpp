@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "CombatMemory.h"
+
+DEFINE_STAT(STAT_HNSMemBuffs);
+DEFINE_STAT(STAT_HNSMemSimulatingBodies);
+DEFINE_STAT(STAT_HNSMemNearbyItems);
+DEFINE_STAT(STAT_HNSMemNearbyChests);
+DEFINE_STAT(STAT_HNSMemNearbyEnemies);
+DEFINE_STAT(STAT_HNSMemInventory);
+
+namespace
+{
+	struct FTagCounters
+	{
+		volatile int64 iBytes;
+		volatile int64 iPeakBytes;
+		volatile int32 iAllocs;
+		volatile int32 iTotalAllocs;
+	};
+
+	FTagCounters GTagCounters[(int32)ECombatMemTag::Count];
+
+	FDelegateHandle GDumpTicker;
+
+	void UpdateStat(ECombatMemTag eTag, int64 iBytes)
+	{
+		switch (eTag)
+		{
+		case ECombatMemTag::Buffs: INC_MEMORY_STAT_BY(STAT_HNSMemBuffs, iBytes); break;
+		case ECombatMemTag::SimulatingBodies: INC_MEMORY_STAT_BY(STAT_HNSMemSimulatingBodies, iBytes); break;
+		case ECombatMemTag::NearbyItems: INC_MEMORY_STAT_BY(STAT_HNSMemNearbyItems, iBytes); break;
+		case ECombatMemTag::NearbyChests: INC_MEMORY_STAT_BY(STAT_HNSMemNearbyChests, iBytes); break;
+		case ECombatMemTag::NearbyEnemies: INC_MEMORY_STAT_BY(STAT_HNSMemNearbyEnemies, iBytes); break;
+		case ECombatMemTag::Inventory: INC_MEMORY_STAT_BY(STAT_HNSMemInventory, iBytes); break;
+		}
+	}
+
+	void DumpCommand(const TArray<FString>& asArgs)
+	{
+		FCombatMemory::DumpCsv(asArgs.Num() > 0 ? asArgs[0] : FString());
+	}
+
+	bool DumpTick(float DeltaTime)
+	{
+		FCombatMemory::DumpCsv(FString());
+		return true;
+	}
+
+	// dump every few seconds for the length of a session
+	void DumpEveryCommand(const TArray<FString>& asArgs)
+	{
+		if (GDumpTicker.IsValid())
+		{
+			FTicker::GetCoreTicker().RemoveTicker(GDumpTicker);
+			GDumpTicker.Reset();
+		}
+
+		float fInterval = asArgs.Num() > 0 ? FCString::Atof(*asArgs[0]) : 0.0f;
+
+		if (fInterval > 0.0f)
+		{
+			GDumpTicker = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&DumpTick), fInterval);
+		}
+	}
+
+	FAutoConsoleCommand GCombatMemReportCommand(
+		TEXT("HNS.CombatMem"),
+		TEXT("Log live heap bytes and allocations of combat containers"),
+		FConsoleCommandDelegate::CreateStatic(&FCombatMemory::Report));
+
+	FAutoConsoleCommand GCombatMemDumpCommand(
+		TEXT("HNS.CombatMemDump"),
+		TEXT("Append combat container memory to a csv. Optional argument: file path"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&DumpCommand));
+
+	FAutoConsoleCommand GCombatMemDumpEveryCommand(
+		TEXT("HNS.CombatMemDumpEvery"),
+		TEXT("Append combat container memory to the default csv every N seconds, 0 stops"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&DumpEveryCommand));
+}
+
+void FCombatMemory::Alloc(ECombatMemTag eTag, int64 iBytes, int32 iAllocs)
+{
+	FTagCounters& oCounters = GTagCounters[(int32)eTag];
+
+	int64 iNow = FPlatformAtomics::InterlockedAdd(&oCounters.iBytes, iBytes) + iBytes;
+
+	FPlatformAtomics::InterlockedAdd(&oCounters.iAllocs, iAllocs);
+	FPlatformAtomics::InterlockedAdd(&oCounters.iTotalAllocs, iAllocs);
+
+	// raise the peak unless another thread raised it further
+	for (int64 iPeak = oCounters.iPeakBytes; iNow > iPeak; iPeak = oCounters.iPeakBytes)
+		if (FPlatformAtomics::InterlockedCompareExchange(&oCounters.iPeakBytes, iNow, iPeak) == iPeak)
+			break;
+
+	UpdateStat(eTag, iBytes);
+}
+
+void FCombatMemory::Free(ECombatMemTag eTag, int64 iBytes, int32 iAllocs)
+{
+	FTagCounters& oCounters = GTagCounters[(int32)eTag];
+
+	FPlatformAtomics::InterlockedAdd(&oCounters.iBytes, -iBytes);
+	FPlatformAtomics::InterlockedAdd(&oCounters.iAllocs, -iAllocs);
+
+	UpdateStat(eTag, -iBytes);
+}
+
+const TCHAR* FCombatMemory::GetTagName(ECombatMemTag eTag)
+{
+	switch (eTag)
+	{
+	case ECombatMemTag::Buffs: return TEXT("Buffs");
+	case ECombatMemTag::SimulatingBodies: return TEXT("SimulatingBodies");
+	case ECombatMemTag::NearbyItems: return TEXT("NearbyItems");
+	case ECombatMemTag::NearbyChests: return TEXT("NearbyChests");
+	case ECombatMemTag::NearbyEnemies: return TEXT("NearbyEnemies");
+	case ECombatMemTag::Inventory: return TEXT("Inventory");
+	default: return TEXT("Unknown");
+	}
+}
+
+int64 FCombatMemory::GetBytes(ECombatMemTag eTag)
+{
+	return GTagCounters[(int32)eTag].iBytes;
+}
+
+void FCombatMemory::Report()
+{
+	for (int32 iTag = 0; iTag < (int32)ECombatMemTag::Count; iTag++)
+	{
+		const FTagCounters& oCounters = GTagCounters[iTag];
+
+		UE_LOG(LogTemp, Log, TEXT("%s: %lld bytes in %d allocations, peak %lld bytes, %d allocations made"), GetTagName((ECombatMemTag)iTag),
+			oCounters.iBytes, oCounters.iAllocs, oCounters.iPeakBytes, oCounters.iTotalAllocs);
+	}
+}
+
+void FCombatMemory::DumpCsv(const FString& sPath)
+{
+	FString sFile = sPath.IsEmpty() ? FPaths::ProfilingDir() / TEXT("CombatMemory.csv") : sPath;
+
+	FString sRows;
+
+	// header for a new file
+	if (IFileManager::Get().FileSize(*sFile) <= 0)
+		sRows = TEXT("Time,Tag,Bytes,Allocs,PeakBytes,TotalAllocs\n");
+
+	double fTime = FPlatformTime::Seconds() - GStartTime;
+
+	for (int32 iTag = 0; iTag < (int32)ECombatMemTag::Count; iTag++)
+	{
+		const FTagCounters& oCounters = GTagCounters[iTag];
+
+		sRows += FString::Printf(TEXT("%.1f,%s,%lld,%d,%lld,%d\n"), fTime, GetTagName((ECombatMemTag)iTag), oCounters.iBytes, oCounters.iAllocs, oCounters.iPeakBytes, oCounters.iTotalAllocs);
+	}
+
+	if (!FFileHelper::SaveStringToFile(sRows, *sFile, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append))
+		UE_LOG(LogTemp, Warning, TEXT("Could not write combat memory to %s"), *sFile);
+}
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+DECLARE_STATS_GROUP(TEXT("HNS Combat Memory"), STATGROUP_HNSCombatMemory, STATCAT_Advanced);
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Buffs"), STAT_HNSMemBuffs, STATGROUP_HNSCombatMemory, HACKNSLACKS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Simulating Bodies"), STAT_HNSMemSimulatingBodies, STATGROUP_HNSCombatMemory, HACKNSLACKS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Nearby Items"), STAT_HNSMemNearbyItems, STATGROUP_HNSCombatMemory, HACKNSLACKS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Nearby Chests"), STAT_HNSMemNearbyChests, STATGROUP_HNSCombatMemory, HACKNSLACKS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Nearby Enemies"), STAT_HNSMemNearbyEnemies, STATGROUP_HNSCombatMemory, HACKNSLACKS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Inventory Records"), STAT_HNSMemInventory, STATGROUP_HNSCombatMemory, HACKNSLACKS_API);
+
+// combat containers whose heap memory is counted
+enum class ECombatMemTag : uint8
+{
+	Buffs,
+	SimulatingBodies,
+	NearbyItems,
+	NearbyChests,
+	NearbyEnemies,
+	Inventory,
+	Count
+};
+
+// live heap bytes and allocations per combat container type, shown in "stat HNSCombatMemory" and logged or dumped by console command
+struct HACKNSLACKS_API FCombatMemory
+{
+	// any thread
+	static void Alloc(ECombatMemTag eTag, int64 iBytes, int32 iAllocs);
+
+	static void Free(ECombatMemTag eTag, int64 iBytes, int32 iAllocs);
+
+	static const TCHAR* GetTagName(ECombatMemTag eTag);
+
+	// live bytes for a tag
+	static int64 GetBytes(ECombatMemTag eTag);
+
+	// log every tag
+	static void Report();
+
+	// append one row per tag to a csv, for servers without a console - empty path uses the Saved/Profiling default
+	static void DumpCsv(const FString& sPath);
+};
+
+// linked list that counts its nodes against a tag - each node is its own heap allocation
+template<typename T, ECombatMemTag Tag>
+class TTrackedList : public TDoubleLinkedList<T>
+{
+	typedef TDoubleLinkedList<T> Super;
+
+	enum { NodeSize = sizeof(typename Super::TDoubleLinkedListNode) };
+
+public:
+	TTrackedList() {}
+
+	~TTrackedList()
+	{
+		Empty();
+	}
+
+	bool AddHead(const T& oElement)
+	{
+		if (!Super::AddHead(oElement))
+			return false;
+
+		FCombatMemory::Alloc(Tag, NodeSize, 1);
+		return true;
+	}
+
+	bool AddTail(const T& oElement)
+	{
+		if (!Super::AddTail(oElement))
+			return false;
+
+		FCombatMemory::Alloc(Tag, NodeSize, 1);
+		return true;
+	}
+
+	void RemoveNode(typename Super::TDoubleLinkedListNode* pkNode, bool bDeleteNode = true)
+	{
+		if (!pkNode)
+			return;
+
+		Super::RemoveNode(pkNode, bDeleteNode);
+
+		// a node kept by the caller no longer belongs to the list
+		FCombatMemory::Free(Tag, NodeSize, 1);
+	}
+
+	void RemoveNode(const T& oElement, bool bDeleteNode = true)
+	{
+		RemoveNode(Super::FindNode(oElement), bDeleteNode);
+	}
+
+	void Empty()
+	{
+		FCombatMemory::Free(Tag, (int64)Super::Num() * NodeSize, Super::Num());
+
+		Super::Empty();
+	}
+
+private:
+	// nodes are counted on insert, copying would count them twice
+	TTrackedList(const TTrackedList&);
+	TTrackedList& operator=(const TTrackedList&);
+};
+
+// counts the allocation of a container that reports its own size, such as a TArray - call Update after it may have grown or shrunk
+template<ECombatMemTag Tag>
+struct TTrackedSize
+{
+	TTrackedSize() : iBytes(0) {}
+
+	~TTrackedSize()
+	{
+		Update(0);
+	}
+
+	FORCEINLINE void Update(SIZE_T iNowBytes)
+	{
+		if ((int64)iNowBytes == iBytes)
+			return;
+
+		// one allocation while the container holds any memory
+		const int32 iAllocs = (iNowBytes > 0 ? 1 : 0) - (iBytes > 0 ? 1 : 0);
+
+		if ((int64)iNowBytes > iBytes)
+			FCombatMemory::Alloc(Tag, iNowBytes - iBytes, iAllocs);
+		else
+			FCombatMemory::Free(Tag, iBytes - iNowBytes, -iAllocs);
+
+		iBytes = iNowBytes;
+	}
+
+private:
+	int64 iBytes;
+};
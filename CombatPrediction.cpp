@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HackNSlacksCharacter.h"
+#include "CombatPrediction.h"
+
+namespace
+{
+	// every buffer, for the stats report
+	TArray<FCombatPredictionBuffer*> GPredictionBuffers;
+
+	FAutoConsoleCommand GPredictionReportCommand(
+		TEXT("HNS.PredictionReport"),
+		TEXT("Log combat prediction correction rate and reconciliation cost"),
+		FConsoleCommandDelegate::CreateStatic(&FCombatPredictionBuffer::ReportStats));
+}
+
+const float FPredictedCombatState::TimerTolerance = 0.01f;
+
+//////////////////////////////////////////////////////////////////////////
+// FPredictedCombatState
+
+FPredictedCombatState::FPredictedCombatState()
+{
+	poCurrentAttack = nullptr;
+
+	fComboTimer = 0.0f;
+	fChargeTimer = 0.0f;
+	fDodgeLockTimer = 0.0f;
+
+	iDodgeCount = 0;
+
+	bCharging = false;
+	bDodging = false;
+}
+
+void FPredictedCombatState::Capture(const AHackNSlacksCharacter* pkCharacter)
+{
+	poCurrentAttack = pkCharacter->oHot.poCurrentAttack;
+
+	fComboTimer = pkCharacter->oHot.fComboTimer;
+	fChargeTimer = pkCharacter->oHot.fChargeTimer;
+	fDodgeLockTimer = pkCharacter->oHot.fDodgeLockTimer;
+
+	iDodgeCount = pkCharacter->oHot.iDodgeCount;
+
+	bCharging = pkCharacter->oHot.bCharging;
+	bDodging = pkCharacter->oHot.bDodging;
+}
+
+void FPredictedCombatState::Apply(AHackNSlacksCharacter* pkCharacter) const
+{
+	pkCharacter->SetCurrentAttack(poCurrentAttack);
+
+	pkCharacter->oHot.fComboTimer = fComboTimer;
+	pkCharacter->oHot.fChargeTimer = fChargeTimer;
+	pkCharacter->oHot.fDodgeLockTimer = fDodgeLockTimer;
+
+	pkCharacter->oHot.iDodgeCount = iDodgeCount;
+
+	pkCharacter->oHot.bCharging = bCharging;
+	pkCharacter->oHot.bDodging = bDodging;
+}
+
+bool FPredictedCombatState::MatchesDiscrete(const FPredictedCombatState& oOther) const
+{
+	return poCurrentAttack == oOther.poCurrentAttack && iDodgeCount == oOther.iDodgeCount && bCharging == oOther.bCharging && bDodging == oOther.bDodging;
+}
+
+bool FPredictedCombatState::Matches(const FPredictedCombatState& oOther) const
+{
+	return MatchesDiscrete(oOther)
+		&& FMath::Abs(fComboTimer - oOther.fComboTimer) <= TimerTolerance
+		&& FMath::Abs(fChargeTimer - oOther.fChargeTimer) <= TimerTolerance
+		&& FMath::Abs(fDodgeLockTimer - oOther.fDodgeLockTimer) <= TimerTolerance;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FCombatPredictionBuffer
+
+FCombatPredictionBuffer::FCombatPredictionBuffer()
+{
+	for (FPredictedFrame& oFrame : aoFrames)
+	{
+		oFrame.iFrame = INDEX_NONE;
+		oFrame.fDeltaTime = 0.0f;
+	}
+
+	iCurrentFrame = 0;
+	aoFrames[0].iFrame = 0;
+
+	iChecks = 0;
+	iCorrections = 0;
+	iStale = 0;
+	iReplayedFrames = 0;
+	fReconcileSeconds = 0.0;
+	fMaxReconcileSeconds = 0.0;
+
+	GPredictionBuffers.Add(this);
+}
+
+FCombatPredictionBuffer::~FCombatPredictionBuffer()
+{
+	GPredictionBuffers.Remove(this);
+}
+
+void FCombatPredictionBuffer::AddInput(EPredictedInput eInput, const FVector& oDir)
+{
+	FPredictedInputEvent oInput;
+	oInput.eInput = eInput;
+	oInput.oDir = oDir;
+
+	aoFrames[iCurrentFrame % HistorySize].aoInputs.Add(oInput);
+}
+
+void FCombatPredictionBuffer::EndFrame(float fDeltaTime, const AHackNSlacksCharacter* pkCharacter)
+{
+	FPredictedFrame& oFrame = aoFrames[iCurrentFrame % HistorySize];
+
+	oFrame.fDeltaTime = fDeltaTime;
+	oFrame.oState.Capture(pkCharacter);
+
+	// open the next frame over the oldest one
+	FPredictedFrame& oNextFrame = aoFrames[++iCurrentFrame % HistorySize];
+
+	oNextFrame.iFrame = iCurrentFrame;
+	oNextFrame.fDeltaTime = 0.0f;
+	oNextFrame.aoInputs.Reset();
+}
+
+FPredictedFrame* FCombatPredictionBuffer::FindFrame(int32 iFrame)
+{
+	if (iFrame < 0 || iFrame > iCurrentFrame)
+		return nullptr;
+
+	FPredictedFrame& oFrame = aoFrames[iFrame % HistorySize];
+
+	return oFrame.iFrame == iFrame ? &oFrame : nullptr;
+}
+
+int32 FCombatPredictionBuffer::FindAlignedFrame(int32 iInputFrame, float fTimeSince)
+{
+	// both sides run the same fixed steps, so the server's elapsed time is a whole number of them
+	int32 iSteps = FMath::RoundToInt(fTimeSince / AHackNSlacksCharacter::CombatStepTime);
+
+	int32 iAligned = iInputFrame + iSteps - 1;
+
+	if (iSteps < 1 || iAligned >= iCurrentFrame || !FindFrame(iInputFrame) || !FindFrame(iAligned))
+		return INDEX_NONE;
+
+	return iAligned;
+}
+
+void FCombatPredictionBuffer::RecordMatch()
+{
+	iChecks++;
+}
+
+void FCombatPredictionBuffer::RecordCorrection(int32 iReplayed, double fSeconds)
+{
+	iChecks++;
+	iCorrections++;
+
+	iReplayedFrames += iReplayed;
+	fReconcileSeconds += fSeconds;
+	fMaxReconcileSeconds = FMath::Max(fMaxReconcileSeconds, fSeconds);
+}
+
+void FCombatPredictionBuffer::RecordStale()
+{
+	iStale++;
+}
+
+void FCombatPredictionBuffer::ReportStats()
+{
+	for (int32 iBuffer = 0; iBuffer < GPredictionBuffers.Num(); iBuffer++)
+	{
+		FCombatPredictionBuffer* poBuffer = GPredictionBuffers[iBuffer];
+
+		int32 iCorrections = FMath::Max(poBuffer->iCorrections, 1);
+
+		UE_LOG(LogTemp, Log, TEXT("Prediction %d: %d of %d checks corrected (%.1f%%), %d stale, %.1f frames replayed per correction, %.3f ms average / %.3f ms max reconcile"),
+			iBuffer, poBuffer->iCorrections, poBuffer->iChecks, poBuffer->iChecks > 0 ? 100.0f * poBuffer->iCorrections / poBuffer->iChecks : 0.0f, poBuffer->iStale,
+			(double)poBuffer->iReplayedFrames / iCorrections, poBuffer->fReconcileSeconds * 1000.0 / iCorrections, poBuffer->fMaxReconcileSeconds * 1000.0);
+	}
+}
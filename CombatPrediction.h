@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AHackNSlacksCharacter;
+struct FAttackEntry;
+
+// inputs the owning client runs before the server confirms them
+enum class EPredictedInput : uint8
+{
+	LightAttack,
+	HeavyAttack,
+	EndCharge,
+	Dodge,
+	Count
+};
+
+// combo and dodge state that is rewound and replayed when the server disagrees
+struct HACKNSLACKS_API FPredictedCombatState
+{
+	// timers further apart than this are a misprediction - a little over one combat step, both sides run the same steps
+	static const float TimerTolerance;
+
+	FPredictedCombatState();
+
+	void Capture(const AHackNSlacksCharacter* pkCharacter);
+
+	// state only - no animation, effects or movement
+	void Apply(AHackNSlacksCharacter* pkCharacter) const;
+
+	// same attack, charge and dodge state
+	bool MatchesDiscrete(const FPredictedCombatState& oOther) const;
+
+	// same discrete state and timers within TimerTolerance
+	bool Matches(const FPredictedCombatState& oOther) const;
+
+	FAttackEntry* poCurrentAttack;
+
+	float fComboTimer;
+	float fChargeTimer;
+	float fDodgeLockTimer;
+
+	int32 iDodgeCount;
+
+	bool bCharging;
+	bool bDodging;
+};
+
+struct FPredictedInputEvent
+{
+	EPredictedInput eInput;
+
+	// dodge direction
+	FVector oDir;
+};
+
+// one fixed combat step on the client - inputs applied before the step and the state after it
+struct FPredictedFrame
+{
+	int32 iFrame;
+	float fDeltaTime;
+
+	TArray<FPredictedInputEvent, TInlineAllocator<2>> aoInputs;
+
+	FPredictedCombatState oState;
+};
+
+// owning client's history of predicted combat steps, keyed by step index
+class HACKNSLACKS_API FCombatPredictionBuffer
+{
+public:
+	FCombatPredictionBuffer();
+	~FCombatPredictionBuffer();
+
+	// step that inputs are currently recorded into
+	FORCEINLINE int32 GetFrame() const { return iCurrentFrame; }
+
+	// record an input into the current frame
+	void AddInput(EPredictedInput eInput, const FVector& oDir);
+
+	// close the current step after it has run
+	void EndFrame(float fDeltaTime, const AHackNSlacksCharacter* pkCharacter);
+
+	// frame still in the history, nullptr once it has been overwritten - includes the open frame
+	FPredictedFrame* FindFrame(int32 iFrame);
+
+	// closed step that had run fTimeSince seconds of combat since the inputs of iInputFrame - INDEX_NONE if they left the history
+	int32 FindAlignedFrame(int32 iInputFrame, float fTimeSince);
+
+	// server state agreed with the prediction
+	void RecordMatch();
+
+	// server state disagreed and iReplayed frames were replayed
+	void RecordCorrection(int32 iReplayed, double fSeconds);
+
+	// server state arrived for a frame no longer in the history
+	void RecordStale();
+
+	// log correction rate and reconciliation cost for every buffer
+	static void ReportStats();
+
+private:
+	// about two seconds of combat steps, enough for any round trip that is still playable
+	static const int32 HistorySize = 256;
+
+	FPredictedFrame aoFrames[HistorySize];
+
+	int32 iCurrentFrame;
+
+	// stats
+	int32 iChecks;
+	int32 iCorrections;
+	int32 iStale;
+	int64 iReplayedFrames;
+	double fReconcileSeconds;
+	double fMaxReconcileSeconds;
+};
@@ -0,0 +1,833 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "BuffDef.h"
+#include "AttackEntry.h"
+#include "AttackDictionary.h"
+#include "CharacterAnimInstance.h"
+#include "HackNSlacksCharacter.h"
+#include "CombatReplication.h"
+
+namespace
+{
+	const int32 AttackBits = 10;
+	const int32 BuffDefBits = 8;
+	const int32 BuffSlotCountBits = 5;
+
+	// all ones marks "none" for dictionary indices
+	const uint32 NoAttack = (1 << AttackBits) - 1;
+	const uint32 NoBuffDef = (1 << BuffDefBits) - 1;
+
+	const uint32 HealthMax = (1 << FCombatNetState::HealthBits) - 1;
+	const uint32 BuffTimeMax = (1 << FCombatNetState::BuffTimeBits) - 1;
+
+	void WriteUInt(FBitWriter& oWriter, uint32 iValue, int32 iBits)
+	{
+		oWriter.SerializeBits(&iValue, iBits);
+	}
+
+	uint32 ReadUInt(FBitReader& oReader, int32 iBits)
+	{
+		uint32 iValue = 0;
+		oReader.SerializeBits(&iValue, iBits);
+
+		return iValue;
+	}
+
+	// dictionary index, or the all ones value when the entry is missing or does not fit
+	void WriteIndex(FBitWriter& oWriter, int32 iIndex, int32 iBits)
+	{
+		uint32 iNone = (1 << iBits) - 1;
+
+		WriteUInt(oWriter, (iIndex >= 0 && (uint32)iIndex < iNone) ? (uint32)iIndex : iNone, iBits);
+	}
+
+	int32 ReadIndex(FBitReader& oReader, int32 iBits)
+	{
+		uint32 iValue = ReadUInt(oReader, iBits);
+
+		return iValue == (uint32)(1 << iBits) - 1 ? INDEX_NONE : (int32)iValue;
+	}
+
+	bool BuffsEqual(const FCombatNetState& oA, const FCombatNetState& oB)
+	{
+		if (oA.iNumBuffSlots != oB.iNumBuffSlots)
+			return false;
+
+		for (int32 iSlot = 0; iSlot < oA.iNumBuffSlots; iSlot++)
+			if (oA.aoBuffSlots[iSlot] != oB.aoBuffSlots[iSlot])
+				return false;
+
+		return true;
+	}
+
+	bool StatesEqual(const FCombatNetState& oA, const FCombatNetState& oB)
+	{
+		return oA.iAttack == oB.iAttack && oA.iCurrentAttack == oB.iCurrentAttack && oA.iHealth == oB.iHealth
+			&& oA.bDodging == oB.bDodging && oA.bCharging == oB.bCharging && BuffsEqual(oA, oB);
+	}
+
+	void CollectAttacksInValue(UProperty* pkProp, void* pValue, const FString& sPath, TArray<FAttackDictionaryEntry>& aoEntries);
+
+	void CollectAttacksInStruct(UStruct* pkStruct, void* pData, const FString& sPath, TArray<FAttackDictionaryEntry>& aoEntries)
+	{
+		for (TFieldIterator<UProperty> kProp(pkStruct); kProp; ++kProp)
+		{
+			for (int32 iElement = 0; iElement < kProp->ArrayDim; iElement++)
+			{
+				FString sPropPath = sPath + TEXT(".") + kProp->GetName();
+
+				if (kProp->ArrayDim > 1)
+					sPropPath += FString::Printf(TEXT("[%d]"), iElement);
+
+				CollectAttacksInValue(*kProp, kProp->ContainerPtrToValuePtr<void>(pData, iElement), sPropPath, aoEntries);
+			}
+		}
+	}
+
+	void CollectAttacksInValue(UProperty* pkProp, void* pValue, const FString& sPath, TArray<FAttackDictionaryEntry>& aoEntries)
+	{
+		if (UStructProperty* pkStructProp = Cast<UStructProperty>(pkProp))
+		{
+			if (pkStructProp->Struct->IsChildOf(FAttackEntry::StaticStruct()))
+			{
+				FAttackDictionaryEntry oEntry;
+
+				oEntry.poEntry = (FAttackEntry*)pValue;
+				oEntry.sId = sPath;
+
+				aoEntries.Add(oEntry);
+			}
+
+			// combos keep their follow up attacks inside the entry
+			CollectAttacksInStruct(pkStructProp->Struct, pValue, sPath, aoEntries);
+		}
+		else if (UArrayProperty* pkArrayProp = Cast<UArrayProperty>(pkProp))
+		{
+			FScriptArrayHelper oArray(pkArrayProp, pValue);
+
+			for (int32 iItem = 0; iItem < oArray.Num(); iItem++)
+				CollectAttacksInValue(pkArrayProp->Inner, oArray.GetRawPtr(iItem), FString::Printf(TEXT("%s[%d]"), *sPath, iItem), aoEntries);
+		}
+	}
+
+	// every channel, for the bandwidth report
+	TArray<FCombatReplicationChannel*> GCombatChannels;
+
+	FAutoConsoleCommand GCombatNetRoundTripCommand(
+		TEXT("HNS.NetRoundTrip"),
+		TEXT("Check that a combat state with an active buff survives a write and read"),
+		FConsoleCommandDelegate::CreateStatic(&FCombatNetState::TestRoundTrip));
+
+	FAutoConsoleCommand GCombatNetReportCommand(
+		TEXT("HNS.NetReport"),
+		TEXT("Log combat state replication bytes per second for each character"),
+		FConsoleCommandDelegate::CreateStatic(&FCombatReplicationChannel::ReportBandwidth));
+}
+
+const float FCombatNetState::BuffTimeStep = 0.5f;
+
+const float FCombatReplicationChannel::BindRetryTime = 0.5f;
+
+namespace
+{
+	// rough wire size of one binding, the id and the actor's net guid
+	const int32 BindingBits = 64;
+
+	// rough wire size of a buff def definition, the index and the class's net guid - attack ids are counted by length
+	const int32 BuffDefinitionBits = 64;
+}
+
+FCombatNetDictionaries& FCombatNetDictionaries::Get()
+{
+	static FCombatNetDictionaries oDictionaries;
+
+	return oDictionaries;
+}
+
+void FCombatNetDictionaries::CollectAttacks(UAttackDictionary* pkDict, TArray<FAttackDictionaryEntry>& aoEntries)
+{
+	if (pkDict)
+		CollectAttacksInStruct(pkDict->GetClass(), pkDict, pkDict->GetClass()->GetPathName(), aoEntries);
+}
+
+void FCombatNetDictionaries::RegisterAttacks(UAttackDictionary* pkDict)
+{
+	if (!pkDict || kRegisteredDicts.Contains(pkDict))
+		return;
+
+	kRegisteredDicts.Add(pkDict);
+
+	TArray<FAttackDictionaryEntry> aoEntries;
+	CollectAttacks(pkDict, aoEntries);
+
+	for (const FAttackDictionaryEntry& oEntry : aoEntries)
+	{
+		oAttacks.Register(oEntry.poEntry);
+		kAttackIds.Add(oEntry.poEntry, oEntry.sId);
+		kAttacksById.Add(oEntry.sId, oEntry.poEntry);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FCombatNetState
+
+FCombatNetState::FCombatNetState()
+{
+	iAttack = INDEX_NONE;
+	iCurrentAttack = 0;
+	iHealth = HealthMax;
+	bDodging = false;
+	bCharging = false;
+	iNumBuffSlots = 0;
+}
+
+void FCombatNetState::Capture(AHackNSlacksCharacter* pkCharacter)
+{
+	FCombatNetDictionaries& oDictionaries = FCombatNetDictionaries::Get();
+
+	iAttack = oDictionaries.oAttacks.Find(pkCharacter->oHot.poCurrentAttack);
+	iCurrentAttack = pkCharacter->iCurrentAttack;
+
+	iHealth = pkCharacter->fMaxHealth > 0.0f ? (uint32)FMath::RoundToInt(FMath::Clamp(pkCharacter->fHealth / pkCharacter->fMaxHealth, 0.0f, 1.0f) * HealthMax) : 0;
+
+	bDodging = pkCharacter->oHot.bDodging;
+	bCharging = pkCharacter->oHot.bCharging;
+
+	// slots follow the character's buff array, inactive buffs keep their slot so only real changes are sent
+	iNumBuffSlots = FMath::Min(pkCharacter->aoBuffs.Num(), MaxBuffSlots);
+
+	for (int32 iSlot = 0; iSlot < iNumBuffSlots; iSlot++)
+	{
+		const FBuff& oBuff = pkCharacter->aoBuffs[iSlot];
+		FBuffSlot& oSlot = aoBuffSlots[iSlot];
+
+		oSlot.iBuffDef = oBuff.bActive ? oDictionaries.oBuffs.Find(oBuff.pkBuffDef) : INDEX_NONE;
+		oSlot.iRemaining = oSlot.iBuffDef != INDEX_NONE ? (uint32)FMath::Clamp(FMath::CeilToInt((oBuff.fDuration - oBuff.fTimer) / BuffTimeStep), 0, (int32)BuffTimeMax) : 0;
+	}
+}
+
+void FCombatNetState::Apply(AHackNSlacksCharacter* pkCharacter, const FCombatReplicationReceiver& oReceiver) const
+{
+	pkCharacter->fHealth = pkCharacter->fMaxHealth * iHealth / (float)HealthMax;
+	pkCharacter->iCurrentAttack = iCurrentAttack;
+
+	// the owning client drives its own attacks and dodges
+	if (!pkCharacter->IsLocallyControlled())
+	{
+		pkCharacter->oHot.bDodging = bDodging;
+		pkCharacter->oHot.bCharging = bCharging;
+
+		FAttackEntry* poAttack = oReceiver.FindAttack(iAttack);
+
+		// an attack not resolved here yet keeps the current one until its definition arrives or its dictionary registers
+		bool bAttackKnown = iAttack == INDEX_NONE || poAttack;
+
+		if (bAttackKnown && poAttack != pkCharacter->oHot.poCurrentAttack)
+		{
+			if (poAttack)
+			{
+				pkCharacter->oHot.fComboTimer = 0.0f;
+				pkCharacter->SetCurrentAttack(poAttack);
+
+				// animation only, attack effects happen on the server
+				if (UCharacterAnimInstance* pkCharAnim = pkCharacter->pkCharAnim)
+					pkCharAnim->SetAnim(poAttack->eBodyPose, poAttack->pkAttackAnim, bCharging ? poAttack->fPlayRate * 0.1f / poAttack->fMaxCharge : poAttack->fPlayRate, true);
+			}
+			else
+				pkCharacter->ResetCombo();
+		}
+	}
+
+	TArray<FBuff>& aoBuffs = pkCharacter->aoBuffs;
+
+	while (aoBuffs.Num() < iNumBuffSlots)
+		aoBuffs.Add(FBuff(pkCharacter));
+
+	for (int32 iSlot = 0; iSlot < aoBuffs.Num(); iSlot++)
+	{
+		FBuff& oBuff = aoBuffs[iSlot];
+
+		int32 iBuffDef = iSlot < iNumBuffSlots ? aoBuffSlots[iSlot].iBuffDef : INDEX_NONE;
+
+		// slot stays as it is until its definition arrives
+		if (iBuffDef != INDEX_NONE && !oReceiver.IsBuffDefDefined(iBuffDef))
+			continue;
+
+		UBuffDef* pkBuffDef = oReceiver.FindBuffDef(iBuffDef);
+
+		oBuff.bActive = pkBuffDef != nullptr;
+
+		if (pkBuffDef)
+		{
+			oBuff.pkBuffDef = pkBuffDef;
+			oBuff.fDuration = aoBuffSlots[iSlot].iRemaining * BuffTimeStep;
+			oBuff.fTimer = 0.0f;
+		}
+	}
+}
+
+void FCombatNetState::WriteDelta(FBitWriter& oWriter, const FCombatNetState& oBase, const FCombatNetState& oState)
+{
+	bool bAttackChanged = oState.iAttack != oBase.iAttack || oState.iCurrentAttack != oBase.iCurrentAttack;
+	bool bHealthChanged = oState.iHealth != oBase.iHealth;
+	bool bFlagsChanged = oState.bDodging != oBase.bDodging || oState.bCharging != oBase.bCharging;
+	bool bBuffsChanged = !BuffsEqual(oState, oBase);
+
+	oWriter.WriteBit(bAttackChanged);
+	oWriter.WriteBit(bHealthChanged);
+	oWriter.WriteBit(bFlagsChanged);
+	oWriter.WriteBit(bBuffsChanged);
+
+	if (bAttackChanged)
+	{
+		WriteIndex(oWriter, oState.iAttack, AttackBits);
+
+		uint32 iCurrentAttack = (uint32)oState.iCurrentAttack;
+		oWriter.SerializeIntPacked(iCurrentAttack);
+	}
+
+	if (bHealthChanged)
+		WriteUInt(oWriter, oState.iHealth, HealthBits);
+
+	if (bFlagsChanged)
+	{
+		oWriter.WriteBit(oState.bDodging);
+		oWriter.WriteBit(oState.bCharging);
+	}
+
+	// buffs go as a slot diff against the baseline
+	if (bBuffsChanged)
+	{
+		WriteUInt(oWriter, oState.iNumBuffSlots, BuffSlotCountBits);
+
+		for (int32 iSlot = 0; iSlot < oState.iNumBuffSlots; iSlot++)
+		{
+			const FBuffSlot& oSlot = oState.aoBuffSlots[iSlot];
+
+			bool bSlotChanged = iSlot >= oBase.iNumBuffSlots || oSlot != oBase.aoBuffSlots[iSlot];
+
+			oWriter.WriteBit(bSlotChanged);
+
+			if (bSlotChanged)
+			{
+				WriteIndex(oWriter, oSlot.iBuffDef, BuffDefBits);
+
+				if (oSlot.iBuffDef != INDEX_NONE)
+					WriteUInt(oWriter, oSlot.iRemaining, BuffTimeBits);
+			}
+		}
+	}
+}
+
+void FCombatNetState::ReadDelta(FBitReader& oReader, const FCombatNetState& oBase, FCombatNetState& oState)
+{
+	oState = oBase;
+
+	bool bAttackChanged = oReader.ReadBit() != 0;
+	bool bHealthChanged = oReader.ReadBit() != 0;
+	bool bFlagsChanged = oReader.ReadBit() != 0;
+	bool bBuffsChanged = oReader.ReadBit() != 0;
+
+	if (bAttackChanged)
+	{
+		oState.iAttack = ReadIndex(oReader, AttackBits);
+
+		uint32 iCurrentAttack = 0;
+		oReader.SerializeIntPacked(iCurrentAttack);
+		oState.iCurrentAttack = (int32)iCurrentAttack;
+	}
+
+	if (bHealthChanged)
+		oState.iHealth = ReadUInt(oReader, HealthBits);
+
+	if (bFlagsChanged)
+	{
+		oState.bDodging = oReader.ReadBit() != 0;
+		oState.bCharging = oReader.ReadBit() != 0;
+	}
+
+	if (bBuffsChanged)
+	{
+		oState.iNumBuffSlots = FMath::Min((int32)ReadUInt(oReader, BuffSlotCountBits), MaxBuffSlots);
+
+		for (int32 iSlot = 0; iSlot < oState.iNumBuffSlots; iSlot++)
+		{
+			FBuffSlot& oSlot = oState.aoBuffSlots[iSlot];
+
+			if (oReader.ReadBit())
+			{
+				oSlot.iBuffDef = ReadIndex(oReader, BuffDefBits);
+				oSlot.iRemaining = oSlot.iBuffDef != INDEX_NONE ? ReadUInt(oReader, BuffTimeBits) : 0;
+			}
+		}
+	}
+}
+
+void FCombatNetState::TestRoundTrip()
+{
+	static const FCombatNetState oDefaultState;
+
+	// the default def stands in for a real one, it registers the same way AddBuff registers defs
+	UBuffDef* pkBuffDef = GetMutableDefault<UBuffDef>();
+
+	int32 iBuffDef = FCombatNetDictionaries::Get().oBuffs.Register(pkBuffDef);
+
+	FCombatNetState oState;
+	oState.iNumBuffSlots = 1;
+	oState.aoBuffSlots[0].iBuffDef = iBuffDef;
+	oState.aoBuffSlots[0].iRemaining = 10;
+
+	FBitWriter oWriter(0, true);
+	WriteDelta(oWriter, oDefaultState, oState);
+
+	FBitReader oReader(oWriter.GetData(), oWriter.GetNumBits());
+
+	FCombatNetState oRead;
+	ReadDelta(oReader, oDefaultState, oRead);
+
+	bool bWire = !oReader.IsError() && StatesEqual(oState, oRead) && oRead.aoBuffSlots[0].iBuffDef == iBuffDef;
+
+	FCombatNetDefinitions oDefinitions;
+	oDefinitions.aiBuffDefs.Add(iBuffDef);
+	oDefinitions.apkBuffClasses.Add(pkBuffDef->GetClass());
+
+	FCombatReplicationReceiver oReceiver;
+	oReceiver.Define(oDefinitions);
+
+	bool bDefinition = oReceiver.FindBuffDef(oRead.aoBuffSlots[0].iBuffDef) == pkBuffDef;
+
+	if (bWire && bDefinition)
+		UE_LOG(LogTemp, Log, TEXT("Combat state round trip passed: buff def %d with %d steps left survived %d bits"), iBuffDef, oRead.aoBuffSlots[0].iRemaining, (int32)oWriter.GetNumBits());
+	else
+		UE_LOG(LogTemp, Error, TEXT("Combat state round trip failed: wire %s, definition %s"), bWire ? TEXT("ok") : TEXT("mismatch"), bDefinition ? TEXT("ok") : TEXT("mismatch"));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FCombatReplicationChannel
+
+FCombatReplicationChannel::FCombatReplicationChannel()
+{
+	for (FSentPacket& oPacket : aoHistory)
+		oPacket.iSequence = INDEX_NONE;
+
+	iNextSequence = 0;
+	iBaseSequence = INDEX_NONE;
+	iNextCharacterID = 0;
+	iBindingsSent = 0;
+	iDefinitionsSent = 0;
+
+	fStartTime = FPlatformTime::Seconds();
+
+	GCombatChannels.Add(this);
+}
+
+FCombatReplicationChannel::~FCombatReplicationChannel()
+{
+	GCombatChannels.Remove(this);
+}
+
+bool FCombatReplicationChannel::WritePacket(const TArray<AHackNSlacksCharacter*>& apkCharacters, TArray<uint8>& aiPacket)
+{
+	static const FCombatNetState oDefaultState;
+
+	int32 iSequence = iNextSequence;
+
+	// baseline has fallen out of the history, send everything in full until the client acks again
+	if (iBaseSequence != INDEX_NONE && iSequence - iBaseSequence >= HistorySize)
+		iBaseSequence = INDEX_NONE;
+
+	FSentPacket* poBase = iBaseSequence != INDEX_NONE ? &aoHistory[iBaseSequence % HistorySize] : nullptr;
+
+	FSentPacket oPacket;
+	oPacket.iSequence = iSequence;
+
+	// characters left out of the packet are unchanged from the baseline
+	if (poBase)
+		oPacket.kStates = poBase->kStates;
+
+	FBitWriter oWriter(0, true);
+
+	uint32 iWireSequence = (uint32)iSequence;
+	uint32 iWireBase = poBase ? (uint32)iBaseSequence + 1 : 0;
+
+	oWriter.SerializeIntPacked(iWireSequence);
+	oWriter.SerializeIntPacked(iWireBase);
+
+	int32 iNumSent = 0;
+
+	for (AHackNSlacksCharacter* pkCharacter : apkCharacters)
+	{
+		if (!pkCharacter || pkCharacter->IsPendingKill())
+			continue;
+
+		uint32* piID = kCharacterIDs.Find(pkCharacter);
+
+		if (!piID)
+		{
+			piID = &kCharacterIDs.Add(pkCharacter, iNextCharacterID++);
+
+			kCharactersByID.Add(*piID, pkCharacter);
+			aiUnbound.Add(*piID);
+		}
+
+		FCombatNetState oState;
+		oState.Capture(pkCharacter);
+
+		const FCombatNetState* poBaseState = oPacket.kStates.Find(*piID);
+
+		if (poBaseState && StatesEqual(*poBaseState, oState))
+			continue;
+
+		int64 iStartBits = oWriter.GetNumBits();
+
+		// continuation bit, then the character's id and delta
+		oWriter.WriteBit(1);
+
+		uint32 iID = *piID;
+		oWriter.SerializeIntPacked(iID);
+
+		FCombatNetState::WriteDelta(oWriter, poBaseState ? *poBaseState : oDefaultState, oState);
+
+		oPacket.kStates.Add(iID, oState);
+		iNumSent++;
+
+		kBitsSent.FindOrAdd(pkCharacter) += oWriter.GetNumBits() - iStartBits;
+
+		DefineAttack(oState.iAttack);
+
+		for (int32 iSlot = 0; iSlot < oState.iNumBuffSlots; iSlot++)
+			DefineBuffDef(oState.aoBuffSlots[iSlot].iBuffDef);
+	}
+
+	oWriter.WriteBit(0);
+
+	// destroyed characters still in the baseline, sent until the client acks a packet without them
+	TArray<uint32> aiDestroyedIDs;
+	PruneDestroyed(aiDestroyedIDs);
+
+	for (auto kIter = oPacket.kStates.CreateIterator(); kIter; ++kIter)
+	{
+		if (kCharactersByID.Contains(kIter.Key()))
+			continue;
+
+		oWriter.WriteBit(1);
+
+		uint32 iID = kIter.Key();
+		oWriter.SerializeIntPacked(iID);
+
+		kIter.RemoveCurrent();
+		iNumSent++;
+	}
+
+	// nothing changed, no packet
+	if (iNumSent == 0)
+		return false;
+
+	oWriter.WriteBit(0);
+
+	aiPacket.Reset();
+	aiPacket.Append(oWriter.GetData(), oWriter.GetNumBytes());
+
+	aoHistory[iSequence % HistorySize] = MoveTemp(oPacket);
+	iNextSequence++;
+
+	return true;
+}
+
+void FCombatReplicationChannel::Ack(int32 iSequence)
+{
+	// only move forward, and only to packets still in the history
+	if (iSequence > iBaseSequence && iSequence < iNextSequence && aoHistory[iSequence % HistorySize].iSequence == iSequence)
+		iBaseSequence = iSequence;
+}
+
+void FCombatReplicationChannel::RequestBindings(const TArray<uint32>& aiIDs)
+{
+	double fNow = FPlatformTime::Seconds();
+
+	for (uint32 iID : aiIDs)
+	{
+		const double* pfBindTime = kBindTimes.Find(iID);
+
+		if (kCharactersByID.Contains(iID) && (!pfBindTime || fNow - *pfBindTime > BindRetryTime))
+			aiUnbound.AddUnique(iID);
+	}
+}
+
+bool FCombatReplicationChannel::TakeBindings(TArray<uint32>& aiIDs, TArray<AHackNSlacksCharacter*>& apkCharacters)
+{
+	double fNow = FPlatformTime::Seconds();
+
+	for (uint32 iID : aiUnbound)
+	{
+		AHackNSlacksCharacter* pkCharacter = kCharactersByID.FindRef(iID).Get();
+
+		if (!pkCharacter)
+			continue;
+
+		aiIDs.Add(iID);
+		apkCharacters.Add(pkCharacter);
+
+		kBindTimes.Add(iID, fNow);
+		kBitsSent.FindOrAdd(pkCharacter) += BindingBits;
+		iBindingsSent++;
+	}
+
+	aiUnbound.Reset();
+
+	return aiIDs.Num() > 0;
+}
+
+void FCombatReplicationChannel::DefineAttack(int32 iAttack)
+{
+	if (iAttack == INDEX_NONE || kDefinedAttacks.Contains(iAttack))
+		return;
+
+	const FString* psId = FCombatNetDictionaries::Get().FindAttackId(FCombatNetDictionaries::Get().oAttacks.Get(iAttack));
+
+	if (!psId)
+		return;
+
+	kDefinedAttacks.Add(iAttack);
+
+	oPendingDefinitions.aiAttacks.Add(iAttack);
+	oPendingDefinitions.asAttackIds.Add(*psId);
+}
+
+void FCombatReplicationChannel::DefineBuffDef(int32 iBuffDef)
+{
+	if (iBuffDef == INDEX_NONE || kDefinedBuffDefs.Contains(iBuffDef))
+		return;
+
+	UBuffDef* pkBuffDef = FCombatNetDictionaries::Get().oBuffs.Get(iBuffDef);
+
+	if (!pkBuffDef)
+		return;
+
+	kDefinedBuffDefs.Add(iBuffDef);
+
+	oPendingDefinitions.aiBuffDefs.Add(iBuffDef);
+	oPendingDefinitions.apkBuffClasses.Add(pkBuffDef->GetClass());
+}
+
+bool FCombatReplicationChannel::TakeDefinitions(FCombatNetDefinitions& oDefinitions)
+{
+	if (oPendingDefinitions.IsEmpty())
+		return false;
+
+	for (const FString& sId : oPendingDefinitions.asAttackIds)
+		iDefinitionsSent += sId.Len() + 4;
+
+	iDefinitionsSent += oPendingDefinitions.aiBuffDefs.Num() * BuffDefinitionBits / 8;
+
+	oDefinitions = MoveTemp(oPendingDefinitions);
+	oPendingDefinitions = FCombatNetDefinitions();
+
+	return true;
+}
+
+void FCombatReplicationChannel::PruneDestroyed(TArray<uint32>& aiDestroyedIDs)
+{
+	for (auto kIter = kCharactersByID.CreateIterator(); kIter; ++kIter)
+	{
+		if (kIter.Value().IsValid() && !kIter.Value()->IsPendingKill())
+			continue;
+
+		aiDestroyedIDs.Add(kIter.Key());
+
+		kCharacterIDs.Remove(kIter.Value());
+		kBindTimes.Remove(kIter.Key());
+		aiUnbound.Remove(kIter.Key());
+
+		kIter.RemoveCurrent();
+	}
+
+	for (auto kIter = kBitsSent.CreateIterator(); kIter; ++kIter)
+		if (!kIter.Key().IsValid())
+			kIter.RemoveCurrent();
+}
+
+void FCombatReplicationChannel::ReportBandwidth()
+{
+	double fNow = FPlatformTime::Seconds();
+
+	for (int32 iChannel = 0; iChannel < GCombatChannels.Num(); iChannel++)
+	{
+		FCombatReplicationChannel* poChannel = GCombatChannels[iChannel];
+
+		double fElapsed = FMath::Max(fNow - poChannel->fStartTime, 0.001);
+		int64 iTotalBits = 0;
+
+		for (auto& kCharacter : poChannel->kBitsSent)
+		{
+			iTotalBits += kCharacter.Value;
+
+			UE_LOG(LogTemp, Log, TEXT("Channel %d %s: %.1f bytes/s"), iChannel, kCharacter.Key.IsValid() ? *kCharacter.Key->GetName() : TEXT("(destroyed)"), kCharacter.Value / 8.0 / fElapsed);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Channel %d total: %.1f bytes/s for %d characters, baseline %d of %d, %d bindings sent, %d bytes of definitions"), iChannel, iTotalBits / 8.0 / fElapsed, poChannel->kBitsSent.Num(), poChannel->iBaseSequence, poChannel->iNextSequence - 1, poChannel->iBindingsSent, poChannel->iDefinitionsSent);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FCombatReplicationReceiver
+
+FCombatReplicationReceiver::FCombatReplicationReceiver()
+{
+	for (FReceivedPacket& oPacket : aoHistory)
+		oPacket.iSequence = INDEX_NONE;
+
+	iLatestSequence = INDEX_NONE;
+}
+
+int32 FCombatReplicationReceiver::ReadPacket(const TArray<uint8>& aiPacket, TArray<uint32>& aiUnknownIDs)
+{
+	static const FCombatNetState oDefaultState;
+
+	FBitReader oReader(const_cast<uint8*>(aiPacket.GetData()), aiPacket.Num() * 8);
+
+	uint32 iWireSequence = 0;
+	uint32 iWireBase = 0;
+
+	oReader.SerializeIntPacked(iWireSequence);
+	oReader.SerializeIntPacked(iWireBase);
+
+	int32 iSequence = (int32)iWireSequence;
+
+	const FReceivedPacket* poBase = nullptr;
+
+	if (iWireBase > 0)
+	{
+		poBase = &aoHistory[(iWireBase - 1) % HistorySize];
+
+		// baseline was never received or has been overwritten
+		if (poBase->iSequence != (int32)iWireBase - 1)
+			return INDEX_NONE;
+	}
+
+	FReceivedPacket oPacket;
+	oPacket.iSequence = iSequence;
+
+	if (poBase)
+		oPacket.kStates = poBase->kStates;
+
+	// unreliable packets can arrive late, older states are kept as baselines but not applied
+	bool bApply = iSequence > iLatestSequence;
+
+	while (!oReader.IsError() && oReader.ReadBit())
+	{
+		uint32 iID = 0;
+		oReader.SerializeIntPacked(iID);
+
+		const FCombatNetState* poBaseState = oPacket.kStates.Find(iID);
+
+		FCombatNetState oState;
+		FCombatNetState::ReadDelta(oReader, poBaseState ? *poBaseState : oDefaultState, oState);
+
+		if (oReader.IsError())
+			break;
+
+		oPacket.kStates.Add(iID, oState);
+
+		AHackNSlacksCharacter* pkCharacter = kCharacters.FindRef(iID).Get();
+
+		// binding or actor has not arrived yet, the state is applied once it is bound
+		if (!pkCharacter)
+			aiUnknownIDs.AddUnique(iID);
+		else if (bApply)
+			oState.Apply(pkCharacter, *this);
+	}
+
+	// characters destroyed on the server
+	while (!oReader.IsError() && oReader.ReadBit())
+	{
+		uint32 iID = 0;
+		oReader.SerializeIntPacked(iID);
+
+		oPacket.kStates.Remove(iID);
+
+		if (bApply)
+			kCharacters.Remove(iID);
+	}
+
+	if (oReader.IsError())
+		return INDEX_NONE;
+
+	aoHistory[iSequence % HistorySize] = MoveTemp(oPacket);
+
+	if (bApply)
+		iLatestSequence = iSequence;
+
+	return iSequence;
+}
+
+void FCombatReplicationReceiver::Bind(const TArray<uint32>& aiIDs, const TArray<AHackNSlacksCharacter*>& apkCharacters)
+{
+	const FReceivedPacket* poLatest = iLatestSequence != INDEX_NONE ? &aoHistory[iLatestSequence % HistorySize] : nullptr;
+
+	if (poLatest && poLatest->iSequence != iLatestSequence)
+		poLatest = nullptr;
+
+	for (int32 iBinding = 0; iBinding < aiIDs.Num() && iBinding < apkCharacters.Num(); iBinding++)
+	{
+		AHackNSlacksCharacter* pkCharacter = apkCharacters[iBinding];
+
+		if (!pkCharacter)
+			continue;
+
+		kCharacters.Add(aiIDs[iBinding], pkCharacter);
+
+		// states that arrived before the binding
+		if (const FCombatNetState* poState = poLatest ? poLatest->kStates.Find(aiIDs[iBinding]) : nullptr)
+			poState->Apply(pkCharacter, *this);
+	}
+}
+
+void FCombatReplicationReceiver::Define(const FCombatNetDefinitions& oDefinitions)
+{
+	for (int32 iAttack = 0; iAttack < oDefinitions.aiAttacks.Num() && iAttack < oDefinitions.asAttackIds.Num(); iAttack++)
+	{
+		kAttackIds.Add(oDefinitions.aiAttacks[iAttack], oDefinitions.asAttackIds[iAttack]);
+		kAttacks.Remove(oDefinitions.aiAttacks[iAttack]);
+	}
+
+	for (int32 iBuffDef = 0; iBuffDef < oDefinitions.aiBuffDefs.Num() && iBuffDef < oDefinitions.apkBuffClasses.Num(); iBuffDef++)
+	{
+		UClass* pkBuffClass = oDefinitions.apkBuffClasses[iBuffDef];
+
+		// a class the client could not load stays a def of nothing, the slot shows as inactive
+		kBuffDefs.Add(oDefinitions.aiBuffDefs[iBuffDef], pkBuffClass && pkBuffClass->IsChildOf(UBuffDef::StaticClass()) ? (UBuffDef*)pkBuffClass->GetDefaultObject() : nullptr);
+	}
+
+	// states that arrived before their definitions
+	const FReceivedPacket* poLatest = iLatestSequence != INDEX_NONE ? &aoHistory[iLatestSequence % HistorySize] : nullptr;
+
+	if (!poLatest || poLatest->iSequence != iLatestSequence)
+		return;
+
+	for (auto& kState : poLatest->kStates)
+		if (AHackNSlacksCharacter* pkCharacter = kCharacters.FindRef(kState.Key).Get())
+			kState.Value.Apply(pkCharacter, *this);
+}
+
+FAttackEntry* FCombatReplicationReceiver::FindAttack(int32 iAttack) const
+{
+	if (FAttackEntry** ppoAttack = kAttacks.Find(iAttack))
+		return *ppoAttack;
+
+	const FString* psId = kAttackIds.Find(iAttack);
+
+	FAttackEntry* poAttack = psId ? FCombatNetDictionaries::Get().FindAttack(*psId) : nullptr;
+
+	// only cache hits, the dictionary may register later
+	if (poAttack)
+		kAttacks.Add(iAttack, poAttack);
+
+	return poAttack;
+}
+
+UBuffDef* FCombatReplicationReceiver::FindBuffDef(int32 iBuffDef) const
+{
+	return kBuffDefs.FindRef(iBuffDef).Get();
+}
@@ -0,0 +1,275 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AHackNSlacksCharacter;
+class UAttackDictionary;
+class UBuffDef;
+class FCombatReplicationReceiver;
+struct FAttackEntry;
+
+// maps pointers to small indices so attacks and buffs can be sent as dictionary indices
+// indices follow the server's registration order and mean nothing on a client - each channel defines the ones it sends, see FCombatNetDefinitions
+template<typename T>
+struct TReplicationDictionary
+{
+	int32 Register(T* pkEntry)
+	{
+		if (const int32* piIndex = kIndices.Find(pkEntry))
+			return *piIndex;
+
+		int32 iIndex = apkEntries.Add(pkEntry);
+		kIndices.Add(pkEntry, iIndex);
+
+		return iIndex;
+	}
+
+	int32 Find(T* pkEntry) const
+	{
+		const int32* piIndex = pkEntry ? kIndices.Find(pkEntry) : nullptr;
+
+		return piIndex ? *piIndex : INDEX_NONE;
+	}
+
+	T* Get(int32 iIndex) const
+	{
+		return apkEntries.IsValidIndex(iIndex) ? apkEntries[iIndex] : nullptr;
+	}
+
+	int32 Num() const { return apkEntries.Num(); }
+
+private:
+	TArray<T*> apkEntries;
+	TMap<T*, int32> kIndices;
+};
+
+// an attack entry inside a dictionary and its property path there, which is the same every run
+struct FAttackDictionaryEntry
+{
+	FAttackEntry* poEntry;
+
+	FString sId;
+};
+
+struct HACKNSLACKS_API FCombatNetDictionaries
+{
+	TReplicationDictionary<FAttackEntry> oAttacks;
+	TReplicationDictionary<UBuffDef> oBuffs;
+
+	static FCombatNetDictionaries& Get();
+
+	// every attack entry in the dictionary, including ones nested in combos - found by walking its properties
+	static void CollectAttacks(UAttackDictionary* pkDict, TArray<FAttackDictionaryEntry>& aoEntries);
+
+	// register every attack in the dictionary once, call as the dictionary is loaded
+	void RegisterAttacks(UAttackDictionary* pkDict);
+
+	// stable id of a registered attack, nullptr if it is not registered
+	const FString* FindAttackId(const FAttackEntry* poAttack) const { return kAttackIds.Find(poAttack); }
+
+	// registered attack with a stable id, nullptr until its dictionary is registered here
+	FAttackEntry* FindAttack(const FString& sId) const { return kAttacksById.FindRef(sId); }
+
+private:
+	TSet<TWeakObjectPtr<UAttackDictionary>> kRegisteredDicts;
+
+	TMap<const FAttackEntry*, FString> kAttackIds;
+
+	TMap<FString, FAttackEntry*> kAttacksById;
+};
+
+// what the server's dictionary indices stand for, sent reliably the first time a channel uses them
+// attacks go by their stable id, buff defs by their class
+struct FCombatNetDefinitions
+{
+	TArray<int32> aiAttacks;
+	TArray<FString> asAttackIds;
+
+	TArray<int32> aiBuffDefs;
+	TArray<UClass*> apkBuffClasses;
+
+	FORCEINLINE bool IsEmpty() const { return aiAttacks.Num() == 0 && aiBuffDefs.Num() == 0; }
+};
+
+// replicated combat state of one character, quantized for the wire
+struct HACKNSLACKS_API FCombatNetState
+{
+	// buff slots beyond this are not replicated
+	static const int32 MaxBuffSlots = 16;
+
+	// health is sent as a fraction of max health
+	static const int32 HealthBits = 10;
+
+	// remaining buff time is sent in steps of BuffTimeStep seconds
+	static const int32 BuffTimeBits = 7;
+	static const float BuffTimeStep;
+
+	struct FBuffSlot
+	{
+		// index in the buff dictionary, INDEX_NONE when the slot is inactive
+		int32 iBuffDef;
+		uint32 iRemaining;
+
+		bool operator==(const FBuffSlot& oOther) const { return iBuffDef == oOther.iBuffDef && iRemaining == oOther.iRemaining; }
+		bool operator!=(const FBuffSlot& oOther) const { return !(*this == oOther); }
+	};
+
+	FCombatNetState();
+
+	void Capture(AHackNSlacksCharacter* pkCharacter);
+
+	// apply on a client - cosmetic only, attack and buff effects stay on the server
+	// indices the receiver has no definition for yet leave the character's attack or buff slot as it is
+	void Apply(AHackNSlacksCharacter* pkCharacter, const FCombatReplicationReceiver& oReceiver) const;
+
+	// log whether a state with an active buff survives a write and read, and whether its def resolves through a definition
+	static void TestRoundTrip();
+
+	// write only the fields that differ from the baseline - one bit when nothing changed
+	static void WriteDelta(FBitWriter& oWriter, const FCombatNetState& oBase, const FCombatNetState& oState);
+
+	static void ReadDelta(FBitReader& oReader, const FCombatNetState& oBase, FCombatNetState& oState);
+
+	// index in the attack dictionary, INDEX_NONE when not attacking
+	int32 iAttack;
+
+	// AI response id of the current attack
+	int32 iCurrentAttack;
+
+	uint32 iHealth;
+
+	bool bDodging;
+	bool bCharging;
+
+	int32 iNumBuffSlots;
+	FBuffSlot aoBuffSlots[MaxBuffSlots];
+};
+
+// server side of the combat state stream to one client - deltas are written against the last packet the client acked
+class HACKNSLACKS_API FCombatReplicationChannel
+{
+public:
+	FCombatReplicationChannel();
+	~FCombatReplicationChannel();
+
+	// write the changed state of the characters into a packet - returns false and writes no packet when nothing changed
+	bool WritePacket(const TArray<AHackNSlacksCharacter*>& apkCharacters, TArray<uint8>& aiPacket);
+
+	// client received a packet, it becomes the delta baseline
+	void Ack(int32 iSequence);
+
+	// client has states for ids it cannot match to an actor, their bindings are sent again
+	void RequestBindings(const TArray<uint32>& aiIDs);
+
+	// ids assigned or requested since the last call and their characters, to send to the client - returns false if there are none
+	bool TakeBindings(TArray<uint32>& aiIDs, TArray<AHackNSlacksCharacter*>& apkCharacters);
+
+	// make sure the client gets a definition for an attack index sent outside the packets
+	void DefineAttack(int32 iAttack);
+
+	// definitions for indices first used since the last call - send them before the packet
+	bool TakeDefinitions(FCombatNetDefinitions& oDefinitions);
+
+	// log bytes per second for each character sent on every open channel
+	static void ReportBandwidth();
+
+private:
+	// states of every character as of one sent packet
+	struct FSentPacket
+	{
+		int32 iSequence;
+		TMap<uint32, FCombatNetState> kStates;
+	};
+
+	// keep enough packets to cover the round trip to the client
+	static const int32 HistorySize = 32;
+
+	// seconds before a requested binding is sent again, covers the reliable send still in flight
+	static const float BindRetryTime;
+
+	void DefineBuffDef(int32 iBuffDef);
+
+	// forget characters destroyed since the last packet - returns their ids
+	void PruneDestroyed(TArray<uint32>& aiDestroyedIDs);
+
+	FSentPacket aoHistory[HistorySize];
+
+	int32 iNextSequence;
+
+	// last acked packet, INDEX_NONE until the client acks one
+	int32 iBaseSequence;
+
+	// character ids on this channel - packets only carry ids, the client learns each id's actor once from a binding
+	TMap<TWeakObjectPtr<AHackNSlacksCharacter>, uint32> kCharacterIDs;
+
+	TMap<uint32, TWeakObjectPtr<AHackNSlacksCharacter>> kCharactersByID;
+
+	uint32 iNextCharacterID;
+
+	// ids whose binding still has to be sent
+	TArray<uint32> aiUnbound;
+
+	// when each id's binding was last sent
+	TMap<uint32, double> kBindTimes;
+
+	// dictionary indices already defined on this channel, and definitions not sent yet
+	TSet<int32> kDefinedAttacks;
+	TSet<int32> kDefinedBuffDefs;
+
+	FCombatNetDefinitions oPendingDefinitions;
+
+	// bandwidth report - packet bits and an estimate for bindings
+	TMap<TWeakObjectPtr<AHackNSlacksCharacter>, int64> kBitsSent;
+
+	int32 iBindingsSent;
+	int32 iDefinitionsSent;
+
+	double fStartTime;
+};
+
+// client side of the combat state stream
+class HACKNSLACKS_API FCombatReplicationReceiver
+{
+public:
+	FCombatReplicationReceiver();
+
+	// decode a packet and apply it to the bound characters, aiUnknownIDs gets ids with no actor yet - returns the sequence to ack, or INDEX_NONE if the baseline is gone
+	int32 ReadPacket(const TArray<uint8>& aiPacket, TArray<uint32>& aiUnknownIDs);
+
+	// learn the actors of channel ids, applying their latest state - null actors have not replicated yet and stay unknown
+	void Bind(const TArray<uint32>& aiIDs, const TArray<AHackNSlacksCharacter*>& apkCharacters);
+
+	// learn what the server's dictionary indices stand for, then apply the latest states again
+	void Define(const FCombatNetDefinitions& oDefinitions);
+
+	// local attack for a server attack index - nullptr if it is undefined or its dictionary is not registered here yet
+	FAttackEntry* FindAttack(int32 iAttack) const;
+
+	UBuffDef* FindBuffDef(int32 iBuffDef) const;
+
+	FORCEINLINE bool IsAttackDefined(int32 iAttack) const { return kAttackIds.Contains(iAttack); }
+
+	FORCEINLINE bool IsBuffDefDefined(int32 iBuffDef) const { return kBuffDefs.Contains(iBuffDef); }
+
+private:
+	struct FReceivedPacket
+	{
+		int32 iSequence;
+		TMap<uint32, FCombatNetState> kStates;
+	};
+
+	static const int32 HistorySize = 32;
+
+	FReceivedPacket aoHistory[HistorySize];
+
+	// newest packet applied to the characters
+	int32 iLatestSequence;
+
+	TMap<uint32, TWeakObjectPtr<AHackNSlacksCharacter>> kCharacters;
+
+	// server dictionary indices - attacks resolve lazily, their dictionary may register after the definition arrives
+	TMap<int32, FString> kAttackIds;
+	mutable TMap<int32, FAttackEntry*> kAttacks;
+
+	TMap<int32, TWeakObjectPtr<UBuffDef>> kBuffDefs;
+};
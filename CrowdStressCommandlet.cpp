@@ -0,0 +1,424 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "Enemy.h"
+#include "HacknSlacksPlayer.h"
+#include "HNSGameInstance.h"
+#include "CombatMemory.h"
+#include "PlayerRegistry.h"
+#include "CrowdStressCommandlet.h"
+
+namespace
+{
+	// stages of a frame timed by the stress test, in the order they run
+	const ETickingGroup StageGroups[] = { TG_PrePhysics, TG_StartPhysics, TG_PostPhysics, TG_PostUpdateWork };
+
+	const TCHAR* const StageNames[] = { TEXT("PrePhysics"), TEXT("Physics"), TEXT("PostPhysics"), TEXT("PostUpdateWork") };
+
+	const int32 StageCount = ARRAY_COUNT(StageGroups);
+
+	// distance the scripted player attacks from
+	const float AttackRange = 200.0f;
+
+	// milliseconds per frame for one measurement
+	struct FTimingSeries
+	{
+		TArray<float> afMs;
+
+		void Add(double fSeconds)
+		{
+			afMs.Add((float)(fSeconds * 1000.0));
+		}
+
+		FString ToJson() const
+		{
+			if (afMs.Num() == 0)
+				return TEXT("{ \"avg\": 0, \"p95\": 0, \"max\": 0 }");
+
+			TArray<float> afSorted = afMs;
+			afSorted.Sort();
+
+			float fTotal = 0.0f;
+
+			for (float fMs : afSorted)
+				fTotal += fMs;
+
+			return FString::Printf(TEXT("{ \"avg\": %.3f, \"p95\": %.3f, \"max\": %.3f }"), fTotal / afSorted.Num(),
+				afSorted[FMath::Min(afSorted.Num() - 1, afSorted.Num() * 95 / 100)], afSorted.Last());
+		}
+	};
+}
+
+FStressStageTickFunction::FStressStageTickFunction()
+{
+	fStartTime = 0.0;
+
+	bCanEverTick = true;
+	bStartWithTickEnabled = true;
+
+	// first in its group, so the time is when the group starts
+	bHighPriority = true;
+}
+
+void FStressStageTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	fStartTime = FPlatformTime::Seconds();
+}
+
+FString FStressStageTickFunction::DiagnosticMessage()
+{
+	return TEXT("[CrowdStressStage]");
+}
+
+UCrowdStressCommandlet::UCrowdStressCommandlet(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+
+	pkPlayer = nullptr;
+
+	fMinSpawnRadius = 600.0f;
+	fMaxSpawnRadius = 2000.0f;
+
+	fNextAttackTime = 0.0f;
+	fNextDodgeTime = 0.0f;
+}
+
+int32 UCrowdStressCommandlet::Main(const FString& Params)
+{
+	FString sMap = TEXT("/Game/Maps/StressArena");
+	FString sEnemyClass;
+	FString sPlayerClass;
+	FString sOutPath = FPaths::ProfilingDir() / TEXT("CrowdStress.json");
+
+	int32 iEnemyCount = 100;
+	int32 iSeed = 0;
+	float fSeconds = 60.0f;
+	float fWarmup = 3.0f;
+	float fFrameRate = 60.0f;
+
+	FParse::Value(*Params, TEXT("Map="), sMap);
+	FParse::Value(*Params, TEXT("Enemy="), sEnemyClass);
+	FParse::Value(*Params, TEXT("Player="), sPlayerClass);
+	FParse::Value(*Params, TEXT("Out="), sOutPath);
+	FParse::Value(*Params, TEXT("Enemies="), iEnemyCount);
+	FParse::Value(*Params, TEXT("Seed="), iSeed);
+	FParse::Value(*Params, TEXT("Seconds="), fSeconds);
+	FParse::Value(*Params, TEXT("Warmup="), fWarmup);
+	FParse::Value(*Params, TEXT("Fps="), fFrameRate);
+	FParse::Value(*Params, TEXT("MinRadius="), fMinSpawnRadius);
+	FParse::Value(*Params, TEXT("MaxRadius="), fMaxSpawnRadius);
+
+	UClass* pkEnemyClass = sEnemyClass.IsEmpty() ? nullptr : LoadClass<AEnemy>(nullptr, *sEnemyClass);
+
+	if (!pkEnemyClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("CrowdStress: -Enemy=<class path> must name an enemy blueprint class, got '%s'"), *sEnemyClass);
+		return 1;
+	}
+
+	UWorld* pkWorld = LoadArena(sMap);
+
+	if (!pkWorld)
+	{
+		UE_LOG(LogTemp, Error, TEXT("CrowdStress: could not load %s"), *sMap);
+		return 1;
+	}
+
+	// the game mode's pawn unless a player class is given
+	UClass* pkPlayerClass = sPlayerClass.IsEmpty() ? nullptr : LoadClass<AHacknSlacksPlayer>(nullptr, *sPlayerClass);
+
+	AGameMode* pkGameMode = pkWorld->GetAuthGameMode();
+
+	if (!pkPlayerClass && pkGameMode && pkGameMode->DefaultPawnClass && pkGameMode->DefaultPawnClass->IsChildOf(AHacknSlacksPlayer::StaticClass()))
+		pkPlayerClass = pkGameMode->DefaultPawnClass;
+
+	if (!pkPlayerClass)
+		pkPlayerClass = AHacknSlacksPlayer::StaticClass();
+
+	AActor* pkStart = pkGameMode ? pkGameMode->FindPlayerStart(nullptr) : nullptr;
+
+	FActorSpawnParameters oParams;
+	oParams.bNoCollisionFail = true;
+
+	pkPlayer = pkWorld->SpawnActor<AHacknSlacksPlayer>(pkPlayerClass, pkStart ? pkStart->GetActorLocation() : FVector::ZeroVector, FRotator::ZeroRotator, oParams);
+
+	if (!pkPlayer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("CrowdStress: could not spawn %s"), *pkPlayerClass->GetName());
+		UnloadArena(pkWorld);
+		return 1;
+	}
+
+	// an ai controller gives the scripted input a control rotation to move relative to
+	pkPlayer->SpawnDefaultController();
+
+	// no local player drives it, take the first slot so targeting runs as it does in game
+	if (FPlayerRegistry* poPlayers = FPlayerRegistry::Get(pkWorld))
+		pkPlayer->iPlayerSlot = poPlayers->Register(pkPlayer, 0);
+
+	// memory is measured around the crowd spawn, after the player and level are loaded
+	uint64 iUsedBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+	oRandom.Initialize(iSeed);
+
+	for (int32 iEnemy = 0; iEnemy < iEnemyCount; iEnemy++)
+		if (AEnemy* pkEnemy = SpawnEnemy(pkWorld, pkEnemyClass))
+			apkEnemies.Add(pkEnemy);
+
+	FStressStageTickFunction aoStages[StageCount];
+
+	for (int32 iStage = 0; iStage < StageCount; iStage++)
+	{
+		aoStages[iStage].TickGroup = StageGroups[iStage];
+		aoStages[iStage].RegisterTickFunction(pkWorld->PersistentLevel);
+	}
+
+	FTimingSeries oGameThread;
+	FTimingSeries oPhysics;
+	FTimingSeries aoStageTimes[StageCount];
+	FTimingSeries oOther;
+
+	const float fDelta = 1.0f / FMath::Max(1.0f, fFrameRate);
+	const int32 iFrames = FMath::CeilToInt((fWarmup + fSeconds) * fFrameRate);
+
+	int32 iDeaths = 0;
+	int32 iMeasuredFrames = 0;
+	uint64 iUsedAfterInit = iUsedBefore;
+
+	for (int32 iFrame = 0; iFrame < iFrames; iFrame++)
+	{
+		const float fTime = pkWorld->GetTimeSeconds();
+
+		DrivePlayer(fTime);
+
+		FApp::SetDeltaTime(fDelta);
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + fDelta);
+
+		double fFrameStart = FPlatformTime::Seconds();
+
+		pkWorld->Tick(LEVELTICK_All, fDelta);
+
+		double fFrameEnd = FPlatformTime::Seconds();
+
+		FTicker::GetCoreTicker().Tick(fDelta);
+		GFrameCounter++;
+
+		// keep the crowd the same size so every measured frame has as many enemies
+		for (int32 iEnemy = 0; iEnemy < apkEnemies.Num(); iEnemy++)
+		{
+			AEnemy* pkEnemy = apkEnemies[iEnemy];
+
+			if (pkEnemy && !pkEnemy->IsPendingKill() && pkEnemy->fHealth > 0.0f)
+				continue;
+
+			iDeaths++;
+			apkEnemies[iEnemy] = SpawnEnemy(pkWorld, pkEnemyClass);
+		}
+
+		// the player only stresses the crowd while alive
+		if (pkPlayer->fHealth < pkPlayer->fMaxHealth * 0.5f)
+			pkPlayer->SetHealth(pkPlayer->fMaxHealth);
+
+		// spawn init and mesh merges have had the warm up to finish
+		if (fTime < fWarmup)
+		{
+			iUsedAfterInit = FPlatformMemory::GetStats().UsedPhysical;
+			continue;
+		}
+
+		iMeasuredFrames++;
+
+		oGameThread.Add(fFrameEnd - fFrameStart);
+
+		// start physics to post physics covers the scene simulating and the game thread waiting for it
+		oPhysics.Add(aoStages[2].fStartTime - aoStages[1].fStartTime);
+
+		double fStagesTime = 0.0;
+
+		for (int32 iStage = 0; iStage < StageCount; iStage++)
+		{
+			double fStageEnd = iStage + 1 < StageCount ? aoStages[iStage + 1].fStartTime : fFrameEnd;
+			double fStageTime = fStageEnd - aoStages[iStage].fStartTime;
+
+			aoStageTimes[iStage].Add(fStageTime);
+			fStagesTime += fStageTime;
+		}
+
+		// streaming, timers and tickable objects outside the tick groups
+		oOther.Add((fFrameEnd - fFrameStart) - fStagesTime);
+	}
+
+	for (int32 iStage = 0; iStage < StageCount; iStage++)
+		aoStages[iStage].UnRegisterTickFunction();
+
+	const int32 iCharacters = FMath::Max(1, iEnemyCount);
+
+	FString sStages;
+
+	for (int32 iStage = 0; iStage < StageCount; iStage++)
+		sStages += FString::Printf(TEXT("\t\t\"%s\": %s,\n"), StageNames[iStage], *aoStageTimes[iStage].ToJson());
+
+	sStages += FString::Printf(TEXT("\t\t\"Other\": %s\n"), *oOther.ToJson());
+
+	// the player's containers are counted too
+	FString sCombatMemory;
+
+	for (int32 iTag = 0; iTag < (int32)ECombatMemTag::Count; iTag++)
+		sCombatMemory += FString::Printf(TEXT("%s\t\t\t\"%s\": %lld"), iTag > 0 ? TEXT(",\n") : TEXT(""), FCombatMemory::GetTagName((ECombatMemTag)iTag), FCombatMemory::GetBytes((ECombatMemTag)iTag) / (iCharacters + 1));
+
+	FString sJson;
+
+	sJson += TEXT("{\n");
+	sJson += FString::Printf(TEXT("\t\"map\": \"%s\",\n"), *sMap);
+	sJson += FString::Printf(TEXT("\t\"enemyClass\": \"%s\",\n"), *pkEnemyClass->GetName());
+	sJson += FString::Printf(TEXT("\t\"enemies\": %d,\n"), iEnemyCount);
+	sJson += FString::Printf(TEXT("\t\"seconds\": %.2f,\n"), fSeconds);
+	sJson += FString::Printf(TEXT("\t\"fixedDeltaMs\": %.3f,\n"), fDelta * 1000.0f);
+	sJson += FString::Printf(TEXT("\t\"frames\": %d,\n"), iMeasuredFrames);
+	sJson += FString::Printf(TEXT("\t\"deaths\": %d,\n"), iDeaths);
+	sJson += FString::Printf(TEXT("\t\"gameThreadMs\": %s,\n"), *oGameThread.ToJson());
+	sJson += FString::Printf(TEXT("\t\"physicsMs\": %s,\n"), *oPhysics.ToJson());
+	sJson += FString::Printf(TEXT("\t\"stagesMs\": {\n%s\t},\n"), *sStages);
+	sJson += TEXT("\t\"memory\": {\n");
+	sJson += FString::Printf(TEXT("\t\t\"bytesPerCharacter\": %lld,\n"), (int64)(iUsedAfterInit - FMath::Min(iUsedBefore, iUsedAfterInit)) / iCharacters);
+	sJson += FString::Printf(TEXT("\t\t\"characterObjectBytes\": %d,\n"), (int32)pkEnemyClass->GetStructureSize());
+	sJson += FString::Printf(TEXT("\t\t\"combatBytesPerCharacter\": {\n%s\n\t\t}\n"), *sCombatMemory);
+	sJson += TEXT("\t}\n");
+	sJson += TEXT("}\n");
+
+	UnloadArena(pkWorld);
+
+	if (!FFileHelper::SaveStringToFile(sJson, *sOutPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("CrowdStress: could not write %s"), *sOutPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("CrowdStress: %d frames with %d enemies written to %s"), iMeasuredFrames, iEnemyCount, *sOutPath);
+
+	return 0;
+}
+
+UWorld* UCrowdStressCommandlet::LoadArena(const FString& sMap)
+{
+	UPackage* pkPackage = LoadPackage(nullptr, *sMap, LOAD_None);
+
+	UWorld* pkWorld = pkPackage ? UWorld::FindWorldInPackage(pkPackage) : nullptr;
+
+	if (!pkWorld)
+		return nullptr;
+
+	pkWorld->WorldType = EWorldType::Game;
+	pkWorld->AddToRoot();
+
+	FWorldContext& oContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	oContext.SetCurrentWorld(pkWorld);
+
+	// the game mode is created through the game instance
+	UHNSGameInstance* pkGameInstance = NewObject<UHNSGameInstance>(GEngine);
+	pkGameInstance->AddToRoot();
+
+	pkWorld->SetGameInstance(pkGameInstance);
+
+	if (!pkWorld->bIsWorldInitialized)
+		pkWorld->InitWorld();
+
+	GWorld = pkWorld;
+
+	FURL oURL(*sMap);
+
+	pkWorld->SetGameMode(oURL);
+	pkWorld->InitializeActorsForPlay(oURL);
+	pkWorld->BeginPlay();
+
+	return pkWorld;
+}
+
+void UCrowdStressCommandlet::UnloadArena(UWorld* pkWorld)
+{
+	UGameInstance* pkGameInstance = pkWorld->GetGameInstance();
+
+	apkEnemies.Empty();
+	pkPlayer = nullptr;
+
+	GEngine->DestroyWorldContext(pkWorld);
+
+	pkWorld->DestroyWorld(false);
+	pkWorld->RemoveFromRoot();
+
+	if (pkGameInstance)
+		pkGameInstance->RemoveFromRoot();
+
+	GWorld = nullptr;
+
+	CollectGarbage(RF_Native);
+}
+
+AEnemy* UCrowdStressCommandlet::SpawnEnemy(UWorld* pkWorld, UClass* pkEnemyClass)
+{
+	float fAngle = oRandom.FRandRange(0.0f, 2.0f * PI);
+	float fDistance = oRandom.FRandRange(fMinSpawnRadius, fMaxSpawnRadius);
+
+	FVector oLocation = pkPlayer->GetActorLocation() + FVector(FMath::Cos(fAngle), FMath::Sin(fAngle), 0.0f) * fDistance;
+
+	FActorSpawnParameters oParams;
+	oParams.bNoCollisionFail = true;
+
+	AEnemy* pkEnemy = pkWorld->SpawnActor<AEnemy>(pkEnemyClass, oLocation, FRotator(0.0f, FMath::RadiansToDegrees(fAngle) + 180.0f, 0.0f), oParams);
+
+	// the enemy blueprint's ai runs the enemy side of the fight
+	if (pkEnemy)
+		pkEnemy->SpawnDefaultController();
+
+	return pkEnemy;
+}
+
+void UCrowdStressCommandlet::DrivePlayer(float fTime)
+{
+	AEnemy* pkClosest = nullptr;
+	float fClosestDistSQ = 0.0f;
+
+	for (AEnemy* pkEnemy : apkEnemies)
+	{
+		if (!pkEnemy || pkEnemy->IsPendingKill() || pkEnemy->fHealth <= 0.0f)
+			continue;
+
+		float fDistSQ = FVector::DistSquared(pkEnemy->GetActorLocation(), pkPlayer->GetActorLocation());
+
+		if (!pkClosest || fDistSQ < fClosestDistSQ)
+		{
+			pkClosest = pkEnemy;
+			fClosestDistSQ = fDistSQ;
+		}
+	}
+
+	if (!pkClosest || !pkPlayer->Controller)
+		return;
+
+	FVector oToEnemy = pkClosest->GetActorLocation() - pkPlayer->GetActorLocation();
+
+	pkPlayer->Controller->SetControlRotation(FRotator(0.0f, oToEnemy.Rotation().Yaw, 0.0f));
+
+	if (fClosestDistSQ > FMath::Square(AttackRange))
+	{
+		pkPlayer->MoveForward(1.0f);
+		return;
+	}
+
+	if (fTime >= fNextAttackTime)
+	{
+		pkPlayer->OnLightAttack();
+		fNextAttackTime = fTime + 0.3f;
+	}
+
+	// dodge now and then so dodge and attack cancel paths are exercised too
+	if (fTime >= fNextDodgeTime)
+	{
+		pkPlayer->Strafe(oRandom.FRand() < 0.5f ? -1.0f : 1.0f);
+		pkPlayer->OnDodge();
+		fNextDodgeTime = fTime + oRandom.FRandRange(2.0f, 4.0f);
+	}
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "Engine/EngineBaseTypes.h"
+#include "CrowdStressCommandlet.generated.h"
+
+class AEnemy;
+class AHacknSlacksPlayer;
+
+// records when its tick group starts each frame, so the stress test can time every stage of a frame
+USTRUCT()
+struct FStressStageTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	FStressStageTickFunction();
+
+	// seconds the tick group started at this frame
+	double fStartTime;
+
+	// FTickFunction
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FStressStageTickFunction> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+// loads a test arena, spawns a crowd of enemies around a scripted player and fights for a fixed time, then writes frame
+// timings and memory per character as json so scalability can be compared between builds
+// UE4Editor-Cmd HacknSlacks -run=CrowdStress -nullrhi -Map=/Game/Maps/StressArena -Enemy=/Game/Blueprints/BP_Enemy.BP_Enemy_C -Enemies=200 -Seconds=60
+UCLASS()
+class UCrowdStressCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCrowdStressCommandlet(const FObjectInitializer& ObjectInitializer);
+
+	// UCommandlet
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	// load the map as a game world and begin play - nullptr if it could not be loaded
+	UWorld* LoadArena(const FString& sMap);
+
+	void UnloadArena(UWorld* pkWorld);
+
+	// spawn an enemy at a random point on a ring around the player
+	AEnemy* SpawnEnemy(UWorld* pkWorld, UClass* pkEnemyClass);
+
+	// face the closest enemy, run at it and attack once in range
+	void DrivePlayer(float fTime);
+
+	AHacknSlacksPlayer* pkPlayer;
+
+	UPROPERTY()
+	TArray<AEnemy*> apkEnemies;
+
+	FRandomStream oRandom;
+
+	// enemies spawn between these distances from the player
+	float fMinSpawnRadius;
+	float fMaxSpawnRadius;
+
+	// next world time the player may attack or dodge
+	float fNextAttackTime;
+	float fNextDodgeTime;
+};
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HackNSlacksCharacter.h"
+#include "HacknSlacksPlayer.h"
+#include "PlayerRegistry.h"
+#include "PerWorld.h"
+#include "DeathQueue.h"
+
+namespace
+{
+	int32 GMaxRagdollsPerFrame = 4;
+	int32 GCorpseDestroyBatch = 4;
+
+	FAutoConsoleVariableRef GMaxRagdollsPerFrameVar(
+		TEXT("HNS.MaxRagdollsPerFrame"),
+		GMaxRagdollsPerFrame,
+		TEXT("Most characters that start ragdolling on death in one frame, the rest wait for later frames."));
+
+	FAutoConsoleVariableRef GCorpseDestroyBatchVar(
+		TEXT("HNS.CorpseDestroyBatch"),
+		GCorpseDestroyBatch,
+		TEXT("Most corpses destroyed in one frame once their lifetime is up."));
+
+	void ReportDeathQueues()
+	{
+		for (auto& kQueue : TPerWorld<FDeathQueue>::GetAll())
+		{
+			if (kQueue.Key.IsValid())
+			{
+				UE_LOG(LogTemp, Log, TEXT("Death queue for %s"), *kQueue.Key->GetName());
+				kQueue.Value->ReportStats();
+			}
+		}
+	}
+
+	FAutoConsoleCommand GDeathStatsCommand(
+		TEXT("HNS.DeathStats"),
+		TEXT("Log characters waiting to ragdoll and corpses waiting to be destroyed"),
+		FConsoleCommandDelegate::CreateStatic(&ReportDeathQueues));
+}
+
+FDeathQueue::FDeathQueue(UWorld* pkInWorld)
+{
+	pkWorld = pkInWorld;
+}
+
+FDeathQueue* FDeathQueue::Get(UWorld* pkWorld)
+{
+	return TPerWorld<FDeathQueue>::Get(pkWorld);
+}
+
+void FDeathQueue::Add(AHackNSlacksCharacter* pkCharacter)
+{
+	apkDying.AddUnique(pkCharacter);
+}
+
+void FDeathQueue::Remove(AHackNSlacksCharacter* pkCharacter)
+{
+	apkDying.Remove(pkCharacter);
+
+	for (int32 iCorpse = aoCorpses.Num() - 1; iCorpse >= 0; iCorpse--)
+		if (aoCorpses[iCorpse].pkCharacter.Get() == pkCharacter)
+			aoCorpses.RemoveAt(iCorpse, 1, false);
+}
+
+void FDeathQueue::ReportStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT("  %d waiting to ragdoll, %d corpses, ragdoll cap %d per frame, destroy batch %d"),
+		apkDying.Num(), aoCorpses.Num(), GMaxRagdollsPerFrame, GCorpseDestroyBatch);
+}
+
+void FDeathQueue::Tick(float DeltaTime)
+{
+	if (!pkWorld.IsValid())
+		return;
+
+	StartRagdolls();
+
+	DestroyCorpses();
+}
+
+void FDeathQueue::StartRagdolls()
+{
+	const int32 iMaxRagdolls = FMath::Max(1, GMaxRagdollsPerFrame);
+
+	const float fTime = pkWorld->GetTimeSeconds();
+
+	int32 iStarted = 0;
+	int32 iHandled = 0;
+
+	for (; iHandled < apkDying.Num() && iStarted < iMaxRagdolls; iHandled++)
+	{
+		AHackNSlacksCharacter* pkCharacter = apkDying[iHandled].Get();
+
+		// destroyed before its turn
+		if (!pkCharacter || pkCharacter->IsPendingKill())
+			continue;
+
+		// healed or restored from a checkpoint while waiting
+		if (!pkCharacter->FinishDeath())
+			continue;
+
+		iStarted++;
+
+		if (pkCharacter->fCorpseLifetime > 0.0f)
+		{
+			FCorpse oCorpse;
+			oCorpse.pkCharacter = pkCharacter;
+			oCorpse.fDestroyTime = fTime + pkCharacter->fCorpseLifetime;
+
+			aoCorpses.Add(oCorpse);
+		}
+	}
+
+	apkDying.RemoveAt(0, iHandled, false);
+
+	if (iStarted == 0)
+		return;
+
+	// one pass over each player's nearby enemies for the whole batch, instead of a removal per death
+	if (FPlayerRegistry* poPlayers = FPlayerRegistry::Get(pkWorld.Get()))
+		for (int32 iSlot = 0; iSlot < FPlayerRegistry::MaxPlayers; iSlot++)
+			if (AHacknSlacksPlayer* pkPlayer = poPlayers->GetPlayer(iSlot))
+				pkPlayer->PruneNearbyEnemies();
+}
+
+void FDeathQueue::DestroyCorpses()
+{
+	const int32 iBatch = FMath::Max(1, GCorpseDestroyBatch);
+
+	const float fTime = pkWorld->GetTimeSeconds();
+
+	int32 iDestroyed = 0;
+
+	for (int32 iCorpse = 0; iCorpse < aoCorpses.Num() && iDestroyed < iBatch; )
+	{
+		FCorpse& oCorpse = aoCorpses[iCorpse];
+
+		AHackNSlacksCharacter* pkCharacter = oCorpse.pkCharacter.Get();
+
+		if (pkCharacter && !pkCharacter->IsPendingKill())
+		{
+			if (oCorpse.fDestroyTime > fTime)
+			{
+				iCorpse++;
+				continue;
+			}
+
+			pkCharacter->Destroy();
+			iDestroyed++;
+		}
+
+		// keep the oldest corpses first
+		aoCorpses.RemoveAt(iCorpse, 1, false);
+	}
+}
+
+bool FDeathQueue::IsTickable() const
+{
+	return apkDying.Num() > 0 || aoCorpses.Num() > 0;
+}
+
+TStatId FDeathQueue::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FDeathQueue, STATGROUP_Tickables);
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Tickable.h"
+
+class AHackNSlacksCharacter;
+
+// where a character is in the death queue
+enum class EDeathStage : uint8
+{
+	Alive,
+	// died, waiting for a ragdoll slot
+	Queued,
+	// ragdolling, destroyed once its corpse lifetime is up
+	Corpse
+};
+
+// characters that died, handled over several frames - a few ragdolls start each frame and corpses are destroyed in
+// small batches, so an attack that kills a crowd at once does not pay for every death in the same frame
+class HACKNSLACKS_API FDeathQueue : public FTickableGameObject
+{
+public:
+	FDeathQueue(UWorld* pkWorld);
+
+	// death queue for a world, created on first use and destroyed with the world - game thread only
+	static FDeathQueue* Get(UWorld* pkWorld);
+
+	void Add(AHackNSlacksCharacter* pkCharacter);
+
+	// forget a queued death or corpse, for characters that are revived
+	void Remove(AHackNSlacksCharacter* pkCharacter);
+
+	// log queued deaths and corpses
+	void ReportStats() const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FCorpse
+	{
+		TWeakObjectPtr<AHackNSlacksCharacter> pkCharacter;
+
+		// world time the corpse is destroyed at
+		float fDestroyTime;
+	};
+
+	// start ragdolls for the oldest deaths, up to the per-frame cap
+	void StartRagdolls();
+
+	// destroy corpses whose lifetime is up, up to the per-frame batch size
+	void DestroyCorpses();
+
+	TWeakObjectPtr<UWorld> pkWorld;
+
+	// deaths are handled in the order they happened
+	TArray<TWeakObjectPtr<AHackNSlacksCharacter>> apkDying;
+
+	TArray<FCorpse> aoCorpses;
+};
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "DeferredTaskScheduler.h"
+
+namespace
+{
+	FAutoConsoleCommand GDeferredStatsCommand(
+		TEXT("HNS.DeferredStats"),
+		TEXT("Log executed and deferred scheduler tasks per frame since the last report"),
+		FConsoleCommandDelegate::CreateStatic(&FDeferredTaskScheduler::ReportStats));
+}
+
+FDeferredTaskScheduler::FDeferredTaskScheduler()
+{
+	fFrameBudget = 0.0005f;
+
+	iNextTask = 1;
+
+	iFrames = 0;
+	iExecuted = 0;
+	iDeferred = 0;
+	iForced = 0;
+}
+
+FDeferredTaskScheduler& FDeferredTaskScheduler::Get()
+{
+	static FDeferredTaskScheduler oScheduler;
+
+	return oScheduler;
+}
+
+int32 FDeferredTaskScheduler::Register(UObject* pkOwner, const FDeferredTask& oTask, int32 iPriority, float fMaxStaleness)
+{
+	FTaskEntry oEntry;
+
+	oEntry.oTask = oTask;
+	oEntry.pkOwner = pkOwner;
+	oEntry.fLastRun = FPlatformTime::Seconds();
+	oEntry.fMaxStaleness = fMaxStaleness;
+	oEntry.iPriority = iPriority;
+	oEntry.iTask = iNextTask++;
+
+	aoTasks.Add(oEntry);
+
+	return oEntry.iTask;
+}
+
+void FDeferredTaskScheduler::Unregister(int32 iTask)
+{
+	// removed on the next tick, tasks can unregister while the scheduler is running them
+	for (FTaskEntry& oEntry : aoTasks)
+		if (oEntry.iTask == iTask)
+			oEntry.oTask.Unbind();
+}
+
+void FDeferredTaskScheduler::Tick(float DeltaTime)
+{
+	double fStartTime = FPlatformTime::Seconds();
+
+	// drop tasks of destroyed owners
+	for (int32 iEntry = aoTasks.Num() - 1; iEntry >= 0; iEntry--)
+		if (!aoTasks[iEntry].pkOwner.IsValid() || !aoTasks[iEntry].oTask.IsBound())
+			aoTasks.RemoveAtSwap(iEntry, 1, false);
+
+	// priority first, then how close each task is to its maximum staleness
+	aoTasks.Sort([fStartTime](const FTaskEntry& oA, const FTaskEntry& oB)
+	{
+		if (oA.iPriority != oB.iPriority)
+			return oA.iPriority > oB.iPriority;
+
+		return (fStartTime - oA.fLastRun) * oB.fMaxStaleness > (fStartTime - oB.fLastRun) * oA.fMaxStaleness;
+	});
+
+	iFrames++;
+
+	for (int32 iEntry = 0; iEntry < aoTasks.Num(); iEntry++)
+	{
+		FTaskEntry& oEntry = aoTasks[iEntry];
+
+		double fNow = FPlatformTime::Seconds();
+		float fElapsed = (float)(fNow - oEntry.fLastRun);
+
+		if (fNow - fStartTime >= fFrameBudget)
+		{
+			if (fElapsed < oEntry.fMaxStaleness)
+			{
+				iDeferred++;
+				continue;
+			}
+
+			iForced++;
+		}
+
+		oEntry.fLastRun = fNow;
+		iExecuted++;
+
+		// the task can register or unregister tasks, so run a copy
+		FDeferredTask oTask = oEntry.oTask;
+		oTask.ExecuteIfBound(fElapsed);
+	}
+}
+
+void FDeferredTaskScheduler::ReportStats()
+{
+	FDeferredTaskScheduler& oScheduler = Get();
+
+	float fFrames = FMath::Max(oScheduler.iFrames, 1);
+
+	UE_LOG(LogTemp, Log, TEXT("Deferred tasks: %d registered, per frame %.2f executed, %.2f deferred, %.2f forced over budget (%d frames)"), oScheduler.aoTasks.Num(),
+		oScheduler.iExecuted / fFrames, oScheduler.iDeferred / fFrames, oScheduler.iForced / fFrames, oScheduler.iFrames);
+
+	oScheduler.iFrames = 0;
+	oScheduler.iExecuted = 0;
+	oScheduler.iDeferred = 0;
+	oScheduler.iForced = 0;
+}
+
+bool FDeferredTaskScheduler::IsTickable() const
+{
+	return aoTasks.Num() > 0;
+}
+
+TStatId FDeferredTaskScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FDeferredTaskScheduler, STATGROUP_Tickables);
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Tickable.h"
+
+// receives the seconds since the task last ran
+DECLARE_DELEGATE_OneParam(FDeferredTask, float);
+
+// runs per-tick work that can fall a few frames behind within a per-frame budget - higher priority and staler tasks run first,
+// and a task that has waited its maximum staleness runs even when the budget is spent
+class HACKNSLACKS_API FDeferredTaskScheduler : public FTickableGameObject
+{
+public:
+	FDeferredTaskScheduler();
+
+	static FDeferredTaskScheduler& Get();
+
+	// the task is dropped once its owner is destroyed - returns a handle for Unregister
+	int32 Register(UObject* pkOwner, const FDeferredTask& oTask, int32 iPriority, float fMaxStaleness);
+
+	void Unregister(int32 iTask);
+
+	// log executed, deferred and forced tasks per frame since the last report
+	static void ReportStats();
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	// seconds of task time allowed per frame
+	float fFrameBudget;
+
+private:
+	struct FTaskEntry
+	{
+		FDeferredTask oTask;
+
+		TWeakObjectPtr<UObject> pkOwner;
+
+		double fLastRun;
+
+		float fMaxStaleness;
+
+		int32 iPriority;
+
+		int32 iTask;
+	};
+
+	TArray<FTaskEntry> aoTasks;
+
+	int32 iNextTask;
+
+	// stats since the last report
+	int32 iFrames;
+	int32 iExecuted;
+	int32 iDeferred;
+
+	// ran past the budget because they reached their maximum staleness
+	int32 iForced;
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HNSNames.h"
+
+const FName FHNSNames::MoveForward(TEXT("MoveForward"));
+const FName FHNSNames::MoveRight(TEXT("MoveRight"));
+const FName FHNSNames::Turn(TEXT("Turn"));
+const FName FHNSNames::TurnRate(TEXT("TurnRate"));
+const FName FHNSNames::LookUp(TEXT("LookUp"));
+const FName FHNSNames::LookUpRate(TEXT("LookUpRate"));
+
+const FName FHNSNames::Jump(TEXT("Jump"));
+const FName FHNSNames::LightAttack(TEXT("LightAttack"));
+const FName FHNSNames::HeavyAttack(TEXT("HeavyAttack"));
+const FName FHNSNames::Dodge(TEXT("Dodge"));
+const FName FHNSNames::SwapWeapon(TEXT("SwapWeapon"));
+const FName FHNSNames::Interact(TEXT("Interact"));
+const FName FHNSNames::Sprint(TEXT("Sprint"));
+const FName FHNSNames::Shoot(TEXT("Shoot"));
+const FName FHNSNames::Aim(TEXT("Aim"));
+const FName FHNSNames::Ability(TEXT("Ability"));
+const FName FHNSNames::CharacterOverview(TEXT("CharacterOverview"));
+const FName FHNSNames::Pause(TEXT("Pause"));
+
+const FName FHNSNames::ParticleFront(TEXT("skt_ParticleFront"));
+const FName FHNSNames::ParticleUpper(TEXT("skt_ParticleUpper"));
+const FName FHNSNames::ParticleLower(TEXT("skt_ParticleLower"));
+
+const FName FHNSNames::Saturation(TEXT("Saturation"));
+const FName FHNSNames::VignetteIntensity(TEXT("VignetteIntensity"));
+
+const FName FHNSNames::Ragdoll(TEXT("Ragdoll"));
+
+const FName FHNSNames::AttackSweep(TEXT("AttackSweep"));
+
+const FName FHNSNames::OnDestroy(TEXT("OnDestroy"));
+const FName FHNSNames::SoftLockSphereBeginOverlap(TEXT("SoftLockSphereBeginOverlap"));
+const FName FHNSNames::SoftLockSphereEndOverlap(TEXT("SoftLockSphereEndOverlap"));
+const FName FHNSNames::OnChunkLoaded(TEXT("OnChunkLoaded"));
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// names used by input bindings, sockets, shader parameters and delegates - hashed once at startup instead of on every lookup
+struct HACKNSLACKS_API FHNSNames
+{
+	// input axes
+	static const FName MoveForward;
+	static const FName MoveRight;
+	static const FName Turn;
+	static const FName TurnRate;
+	static const FName LookUp;
+	static const FName LookUpRate;
+
+	// input actions
+	static const FName Jump;
+	static const FName LightAttack;
+	static const FName HeavyAttack;
+	static const FName Dodge;
+	static const FName SwapWeapon;
+	static const FName Interact;
+	static const FName Sprint;
+	static const FName Shoot;
+	static const FName Aim;
+	static const FName Ability;
+	static const FName CharacterOverview;
+	static const FName Pause;
+
+	// particle sockets
+	static const FName ParticleFront;
+	static const FName ParticleUpper;
+	static const FName ParticleLower;
+
+	// post process shader parameters
+	static const FName Saturation;
+	static const FName VignetteIntensity;
+
+	// collision profiles
+	static const FName Ragdoll;
+
+	// collision query tags
+	static const FName AttackSweep;
+
+	// functions bound to dynamic delegates by name
+	static const FName OnDestroy;
+	static const FName SoftLockSphereBeginOverlap;
+	static const FName SoftLockSphereEndOverlap;
+	static const FName OnChunkLoaded;
+};
@@ -8,20 +8,53 @@
 #include "Weapon.h"
 #include "WeaponSpawn.h"
 #include "Chest.h"
+#include "Item.h"
+#include "HNSNames.h"
 #include "CharacterAnimInstance.h"
 #include "Ability.h"
 #include "AttackEntry.h"
+#include "AttackVelocityTrack.h"
+#include "CombatReplication.h"
+#include "CameraFollowComponent.h"
+#include "CharacterInventoryComponent.h"
+#include "MeshMergeCache.h"
+#include "AttackHitSystem.h"
+#include "WeaponPool.h"
+#include "SpawnInitQueue.h"
+#include "DeferredTaskScheduler.h"
+#include "DeathQueue.h"
+#include "Gear.h"
+#include "AIController.h"
+#include "BrainComponent.h"
 #include "HackNSlacksCharacter.h"
 
+namespace
+{
+	FAutoConsoleCommand GCharacterFootprintCommand(
+		TEXT("HNS.CharacterFootprint"),
+		TEXT("Log object size and allocated bytes per character class"),
+		FConsoleCommandDelegate::CreateStatic(&AHackNSlacksCharacter::ReportFootprint));
+
+	FAutoConsoleCommand GCombatStepsCommand(
+		TEXT("HNS.CombatSteps"),
+		TEXT("Log frames that hit the combat step limit and the combat time they dropped since the last report"),
+		FConsoleCommandDelegate::CreateStatic(&AHackNSlacksCharacter::ReportCombatSteps));
+
+	// combat steps run and time dropped past MaxCombatSteps, over all characters
+	int64 GCombatSteps = 0;
+	int32 GCappedCombatFrames = 0;
+	double GDroppedCombatTime = 0.0;
+	double GCombatStepsSince = 0.0;
+}
+
+const float AHackNSlacksCharacter::CombatStepTime = 1.0f / 120.0f;
+const int32 AHackNSlacksCharacter::MaxCombatSteps = 12;
+
 //////////////////////////////////////////////////////////////////////////
 // AHnS_4_6Character
 
 AHackNSlacksCharacter::AHackNSlacksCharacter(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
-	// FollowCamera Default Values
-	fCameraRotRate = 0.6f;
-	fAngleInfluence = 5.0f;
-
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 
@@ -40,18 +73,44 @@ AHackNSlacksCharacter::AHackNSlacksCharacter(const FObjectInitializer& ObjectIni
 	GetCharacterMovement()->JumpZVelocity = 600.f;
 	GetCharacterMovement()->AirControl = 0.2f;
 
-	bOnGround = true;
+	iAttackEventCursor = 0;
+
+	eInitStage = ESpawnInitStage::Anim;
+	bHiddenBeforeInit = false;
+	bCollisionBeforeInit = true;
+
+	eDeathStage = EDeathStage::Alive;
+	eCapsuleCollisionBeforeRagdoll = ECollisionEnabled::QueryAndPhysics;
+	fCorpseLifetime = 5.0f;
+
+	iAttacksStarted = 0;
+	bPendingAttackCancel = false;
+	iAttacksAtCancel = 0;
+
+	pkCameraFollow = nullptr;
+	pkInventory = nullptr;
+	pkBaseMesh = nullptr;
+
+	for (int32 iSlot = 0; iSlot < (int32)EEquipSlots::Count; iSlot++)
+		apkEquippedGear[iSlot] = nullptr;
+
+	for (int32 iPart = 0; iPart < (int32)EBodyParts::Count; iPart++)
+		apkBodyMeshes[iPart] = nullptr;
 
 	eTeam = ETeams::Enemy;
 
 	for (int32 iSocket = 0; iSocket < (int32)EBodyParts::Count; iSocket++)
+	{
 		apoSockets[iSocket].eBodyPart = (EBodyParts)iSocket;
+		aiSocketBones[iSocket] = INDEX_NONE;
+		aiAttackSwings[iSocket] = 0;
+	}
 
 	fHealth = fMaxHealth;
 	fDamageMultiplier = 1.0f;
 
 	TScriptDelegate<> oOnDestroy;
-	oOnDestroy.BindUFunction(this, "OnDestroy");
+	oOnDestroy.BindUFunction(this, FHNSNames::OnDestroy);
 
 	OnDestroyed.AddUnique(oOnDestroy);
 
@@ -61,7 +120,7 @@ AHackNSlacksCharacter::AHackNSlacksCharacter(const FObjectInitializer& ObjectIni
 
 FAttackEntry* const AHackNSlacksCharacter::GetCurrentAttack()
 {
-	return poCurrentAttack;
+	return oHot.poCurrentAttack;
 }
 
 AWeapon* AHackNSlacksCharacter::GetWeapon()
@@ -74,6 +133,104 @@ const USkeletalMeshSocket* AHackNSlacksCharacter::GetBoneSocket(EBodyParts eBody
 	return apoSockets[(uint32)eBodyPart].pkSocket;
 }
 
+FVector AHackNSlacksCharacter::GetTopSocketLocation() const
+{
+	FVector oTop = GetActorLocation() + FVector(0.0f, 0.0f, GetSimpleCollisionHalfHeight());
+	bool bFound = false;
+
+	for (int32 iSocket = 0; iSocket < (int32)EBodyParts::Count; iSocket++)
+	{
+		if (aiSocketBones[iSocket] == INDEX_NONE)
+			continue;
+
+		const FVector oLoc = aoSocketTransforms[iSocket].GetLocation();
+
+		if (!bFound || oLoc.Z > oTop.Z)
+			oTop = oLoc;
+
+		bFound = true;
+	}
+
+	return oTop;
+}
+
+void AHackNSlacksCharacter::SetAttackSweepActive(EBodyParts eBodyPart, bool bActive, float fRadius)
+{
+	// hits are decided by the server
+	if (Role < ROLE_Authority)
+		return;
+
+	FAttackHitSystem* poHits = FAttackHitSystem::Get(GetWorld());
+
+	int32& iSwing = aiAttackSwings[(int32)eBodyPart];
+
+	if (!poHits || bActive == (iSwing != 0))
+		return;
+
+	if (bActive)
+		iSwing = poHits->BeginSwing(this, eBodyPart, fRadius);
+	else
+	{
+		poHits->EndSwing(iSwing);
+		iSwing = 0;
+	}
+}
+
+void AHackNSlacksCharacter::EndAttackSweeps()
+{
+	for (int32 iPart = 0; iPart < (int32)EBodyParts::Count; iPart++)
+		SetAttackSweepActive((EBodyParts)iPart, false);
+}
+
+void AHackNSlacksCharacter::CacheSocketBones()
+{
+	USkeletalMeshComponent* pkSkeleton = GetMesh();
+
+	for (int32 iSocket = 0; iSocket < (int32)EBodyParts::Count; iSocket++)
+	{
+		const USkeletalMeshSocket* pkSocket = apoSockets[iSocket].pkSocket;
+
+		aiSocketBones[iSocket] = pkSocket && pkSkeleton ? pkSkeleton->GetBoneIndex(pkSocket->BoneName) : INDEX_NONE;
+	}
+
+	UpdateSocketTransforms();
+}
+
+void AHackNSlacksCharacter::UpdateSocketTransforms()
+{
+	USkeletalMeshComponent* pkSkeleton = GetMesh();
+
+	if (!pkSkeleton)
+		return;
+
+	const TArray<FTransform>& aoSpaceBases = pkSkeleton->GetSpaceBases();
+	const FTransform& oComponentToWorld = pkSkeleton->ComponentToWorld;
+
+	for (int32 iSocket = 0; iSocket < (int32)EBodyParts::Count; iSocket++)
+	{
+		const int32 iBone = aiSocketBones[iSocket];
+
+		if (iBone == INDEX_NONE)
+			continue;
+
+		const USkeletalMeshSocket* pkSocket = apoSockets[iSocket].pkSocket;
+		const FTransform oSocketLocal(pkSocket->RelativeRotation, pkSocket->RelativeLocation, pkSocket->RelativeScale);
+
+		if (aoSpaceBases.IsValidIndex(iBone))
+		{
+			aoSocketTransforms[iSocket] = oSocketLocal * aoSpaceBases[iBone] * oComponentToWorld;
+		}
+		else
+		{
+			// meshes following a master pose have no bones of their own
+			FMatrix oSocketMatrix;
+
+			if (pkSocket->GetSocketMatrix(oSocketMatrix, pkSkeleton))
+				aoSocketTransforms[iSocket].SetFromMatrix(oSocketMatrix);
+		}
+	}
+}
+
 UAttackCollider* AHackNSlacksCharacter::GetCollider(EBodyParts eBodyPart)
 {
 	return apkAttackColliders[(int32)eBodyPart];
@@ -84,14 +241,14 @@ void AHackNSlacksCharacter::SetCollider(EBodyParts eBodyPart, UAttackCollider* p
 	apkAttackColliders[(int32)eBodyPart] = pkCollider;
 }
 
-/* FBuff& AHackNSlacksCharacter::AddBuffDefault(TSubclassOf<UBuffDef> pkBuffClass)
+FBuff& AHackNSlacksCharacter::AddBuffDefault(TSubclassOf<UBuffDef> pkBuffClass)
 {
 	UBuffDef* pkBuffDef = (UBuffDef*)pkBuffClass->GetDefaultObject();
 
 	return AddBuff(pkBuffClass, pkBuffDef->fBaseIntensity, pkBuffDef->fBaseDuration, pkBuffDef->iBaseTickCount);
-} */
+}
 
-/* FBuff& AHackNSlacksCharacter::AddBuff(TSubclassOf<UBuffDef> pkBuffClass, float fIntensity, float fDuration, int32 iTickCount)
+FBuff& AHackNSlacksCharacter::AddBuff(TSubclassOf<UBuffDef> pkBuffClass, float fIntensity, float fDuration, int32 iTickCount)
 {
 	UBuffDef* pkBuffDef = (UBuffDef*)pkBuffClass->GetDefaultObject();
 
@@ -125,32 +282,182 @@ void AHackNSlacksCharacter::SetCollider(EBodyParts eBodyPart, UAttackCollider* p
 
 	poBuff->Init(pkBuffDef, fIntensity, fDuration, iTickCount);
 
+	// replicated combat state refers to buff defs by index, registered the first time a def is used
+	FCombatNetDictionaries::Get().oBuffs.Register(pkBuffDef);
+
 	return *poBuff;
-} */
+}
 
 void AHackNSlacksCharacter::AddNearbyItem(AItem* pkNearbyItem)
 {
-	if (!apkNearbyItems.FindNode(pkNearbyItem))
-		apkNearbyItems.AddTail(pkNearbyItem);
+	if (pkInventory)
+		pkInventory->AddNearbyItem(pkNearbyItem);
 }
 
 void AHackNSlacksCharacter::RemoveNearbyItem(AItem* pkNearbyItem)
 {
-	apkNearbyItems.RemoveNode(pkNearbyItem);
-
-	if (pkNearbyItem == pkClosestItem)
+	if (pkInventory && pkInventory->RemoveNearbyItem(pkNearbyItem))
 		GetClosestItem();
 }
 
 void AHackNSlacksCharacter::AddNearbyChest(AChest* pkNearbyChest)
 {
-	if (!apkNearbyChests.FindNode(pkNearbyChest))
-		apkNearbyChests.AddTail(pkNearbyChest);
+	if (pkInventory)
+		pkInventory->AddNearbyChest(pkNearbyChest);
 }
 
 void AHackNSlacksCharacter::RemoveNearbyChest(AChest* pkNearbyChest)
 {
-	apkNearbyChests.RemoveNode(pkNearbyChest);
+	if (pkInventory)
+		pkInventory->RemoveNearbyChest(pkNearbyChest);
+}
+
+bool AHackNSlacksCharacter::AddToInventory(AItem* pkItem)
+{
+	if (!pkInventory || !pkItem || pkItem->IsPendingKill())
+		return false;
+
+	// records are pooled without a limit, a valid class always fits
+	pkInventory->oInventory.Add(pkItem->GetClass(), 1);
+
+	RemoveNearbyItem(pkItem);
+
+	// the record replaces the actor until the item is dropped again
+	pkItem->Destroy();
+
+	return true;
+}
+
+AItem* AHackNSlacksCharacter::DropFromInventory(int32 iRecord)
+{
+	if (!pkInventory || !pkInventory->oInventory.IsValidRecord(iRecord))
+		return nullptr;
+
+	FTransform oDropTransform(GetActorRotation(), GetActorLocation() + GetActorForwardVector() * GetCapsuleComponent()->GetScaledCapsuleRadius() * 2.0f);
+
+	AItem* pkItem = pkInventory->oInventory.SpawnItem(GetWorld(), iRecord, oDropTransform);
+
+	if (pkItem)
+		pkInventory->oInventory.Remove(iRecord, 1);
+
+	return pkItem;
+}
+
+void AHackNSlacksCharacter::RequestMeshMerge()
+{
+	if (GetNetMode() == NM_DedicatedServer)
+		return;
+
+	// unequipped gear should not stay hidden until the merge runs
+	for (USkinnedMeshComponent* pkMerged : apkMergedComponents)
+	{
+		if (pkMerged && pkMerged->GetOwner() != this)
+		{
+			bool bEquipped = false;
+
+			for (AGear* pkGear : apkEquippedGear)
+				bEquipped |= pkGear && pkMerged->GetOwner() == pkGear;
+
+			if (!bEquipped)
+			{
+				pkMerged->SetVisibility(true);
+				pkMerged->SetComponentTickEnabled(true);
+			}
+		}
+	}
+
+	FMeshMergeCache::Get().RequestMerge(this);
+}
+
+bool AHackNSlacksCharacter::UpdateMergedMesh()
+{
+	if (oHot.poCurrentAttack || oHot.bCharging)
+		return false;
+
+	USkeletalMeshComponent* pkSkeleton = GetMesh();
+
+	if (!pkSkeleton)
+		return true;
+
+	if (!pkBaseMesh)
+		pkBaseMesh = pkSkeleton->SkeletalMesh;
+
+	if (!pkBaseMesh)
+		return true;
+
+	USkeleton* pkBaseSkeleton = pkBaseMesh->Skeleton;
+
+	// base mesh first, then body parts and gear in slot order so the same gear always gives the same merge
+	TArray<USkeletalMesh*> apkMeshes;
+	TArray<USkinnedMeshComponent*> apkComponents;
+
+	apkMeshes.Add(pkBaseMesh);
+
+	TArray<USkeletalMeshComponent*> apkParts;
+
+	for (USkeletalMeshComponent* pkBodyMesh : apkBodyMeshes)
+		apkParts.Add(pkBodyMesh);
+
+	for (AGear* pkGear : apkEquippedGear)
+	{
+		if (pkGear)
+		{
+			TArray<USkeletalMeshComponent*> apkGearMeshes;
+			pkGear->GetComponents(apkGearMeshes);
+
+			apkParts.Append(apkGearMeshes);
+		}
+	}
+
+	// meshes on another skeleton stay separate components
+	for (USkeletalMeshComponent* pkPart : apkParts)
+	{
+		if (pkPart && pkPart != pkSkeleton && pkPart->SkeletalMesh && pkPart->SkeletalMesh->Skeleton == pkBaseSkeleton)
+		{
+			apkMeshes.Add(pkPart->SkeletalMesh);
+			apkComponents.Add(pkPart);
+		}
+	}
+
+	USkeletalMesh* pkMerged = apkMeshes.Num() > 1 ? FMeshMergeCache::Get().FindOrMerge(apkMeshes) : pkBaseMesh;
+
+	// keep showing the separate components if the merge failed
+	if (!pkMerged)
+	{
+		pkMerged = pkBaseMesh;
+		apkComponents.Empty();
+	}
+
+	for (USkinnedMeshComponent* pkPart : apkMergedComponents)
+	{
+		if (pkPart && !apkComponents.Contains(pkPart))
+		{
+			pkPart->SetVisibility(true);
+			pkPart->SetComponentTickEnabled(true);
+		}
+	}
+
+	// the merged mesh replaces the parts - no bone updates, bounds or draw calls for them
+	for (USkinnedMeshComponent* pkPart : apkComponents)
+	{
+		pkPart->SetVisibility(false);
+		pkPart->SetComponentTickEnabled(false);
+	}
+
+	apkMergedComponents = apkComponents;
+
+	if (pkSkeleton->SkeletalMesh != pkMerged)
+	{
+		pkSkeleton->SetSkeletalMesh(pkMerged);
+
+		// setting the mesh can create a new anim instance
+		pkCharAnim = Cast<UCharacterAnimInstance>(pkSkeleton->GetAnimInstance());
+
+		// the merged mesh has its own bone order
+		CacheSocketBones();
+	}
+
+	return true;
 }
 
 /*/ called by a weapon when it is picked up
@@ -188,12 +495,12 @@ float AHackNSlacksCharacter::ModHealth(float fMod)
 
 void AHackNSlacksCharacter::SetDodging(bool bIsDodging)
 {
-	bDodging = bIsDodging;
+	oHot.bDodging = bIsDodging;
 }
 
 /*void AHackNSlacksCharacter::OnWalkingOffLedge_Implementation(const FVector& PreviousFloorImpactNormal, const FVector& PreviousFloorContactNormal, const FVector& PreviousLocation, float TimeDelta)
 {
-	if (!poCurrentAttack && !bDodging)
+	if (!oHot.poCurrentAttack && !oHot.bDodging)
 		Super::OnWalkingOffLedge_Implementation(PreviousFloorImpactNormal, PreviousFloorContactNormal, PreviousLocation, TimeDelta);
 } */
 
@@ -253,8 +560,8 @@ void AHackNSlacksCharacter::TurnAtRate(float Rate)
 
 	float fTurnRate = Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds();
 
-	if (poCurrentAttack)
-		fTurnRate *= poCurrentAttack->fTurnControlFactor;
+	if (oHot.poCurrentAttack)
+		fTurnRate *= oHot.poCurrentRecord->fTurnControlFactor;
 
 	// calculate delta for this frame from the rate information
 	AddControllerYawInput(fTurnRate);
@@ -270,12 +577,12 @@ void AHackNSlacksCharacter::MoveForward(float Value)
 {
 	float fMoveControlFactor = 1.0f;
 	
-	if (bDodging)
+	if (oHot.bDodging)
 		fMoveControlFactor = fDodgeMoveControlFactor;
-	else if (iDodgeCount > 0 && fDodgeLockTimer < fDodgeLockDuration)
+	else if (oHot.iDodgeCount > 0 && oHot.fDodgeLockTimer < fDodgeLockDuration)
 		fMoveControlFactor = 0.0f;
-	else if (poCurrentAttack)
-		fMoveControlFactor = poCurrentAttack->fMoveControlFactor;
+	else if (oHot.poCurrentAttack)
+		fMoveControlFactor = oHot.poCurrentRecord->fMoveControlFactor;
 
 	if ((Controller != NULL) && (Value != 0.0f) && fMoveControlFactor != 0.0f)
 	{
@@ -293,12 +600,12 @@ void AHackNSlacksCharacter::Strafe(float Value)
 {
 	float fMoveControlFactor = 1.0f;
 
-	if (bDodging)
+	if (oHot.bDodging)
 		fMoveControlFactor = fDodgeMoveControlFactor;
-	else if (iDodgeCount > 0 && fDodgeLockTimer < fDodgeLockDuration)
+	else if (oHot.iDodgeCount > 0 && oHot.fDodgeLockTimer < fDodgeLockDuration)
 		fMoveControlFactor = 0.0f;
-	else if (poCurrentAttack)
-		fMoveControlFactor = poCurrentAttack->fMoveControlFactor;
+	else if (oHot.poCurrentAttack)
+		fMoveControlFactor = oHot.poCurrentRecord->fMoveControlFactor;
 
 	if ((Controller != NULL) && (Value != 0.0f) && fMoveControlFactor != 0.0f)
 	{
@@ -346,7 +653,7 @@ void AHackNSlacksCharacter::UpdateSimulatingBodies()
 	}
 }
 
-/* void AHackNSlacksCharacter::UpdateBuffs()
+void AHackNSlacksCharacter::UpdateBuffs()
 {
 	float fDelta = GetWorld()->GetDeltaSeconds();
 
@@ -359,9 +666,83 @@ void AHackNSlacksCharacter::UpdateSimulatingBodies()
 		if (poBuff->bActive)
 			poBuff->Update(fDelta);
 	}
-} */
+}
 
 void AHackNSlacksCharacter::OnDeath()
+{
+	if (eDeathStage != EDeathStage::Alive)
+		return;
+
+	FDeathQueue* poDeaths = UsesDeathQueue() ? FDeathQueue::Get(GetWorld()) : nullptr;
+
+	if (!poDeaths)
+	{
+		StopBuffs();
+		return;
+	}
+
+	// many characters can die in one frame, the queue spreads their ragdolls and destruction over later frames
+	eDeathStage = EDeathStage::Queued;
+	poDeaths->Add(this);
+
+	// stop fighting now, only the ragdoll and the list removals wait for the queue
+	StopBuffs();
+
+	ResetCombo();
+
+	if (AAIController* pkAI = Cast<AAIController>(Controller))
+		if (pkAI->BrainComponent)
+			pkAI->BrainComponent->PauseLogic(TEXT("Death"));
+}
+
+bool AHackNSlacksCharacter::FinishDeath()
+{
+	if (fHealth > 0.0f)
+	{
+		// the queue drops the entry itself
+		if (AAIController* pkAI = Cast<AAIController>(Controller))
+			if (pkAI->BrainComponent)
+				pkAI->BrainComponent->ResumeLogic(TEXT("Death"));
+
+		eDeathStage = EDeathStage::Alive;
+		return false;
+	}
+
+	eDeathStage = EDeathStage::Corpse;
+
+	StartDeathRagdoll();
+
+	// a corpse only needs its mesh to tick
+	SetActorTickEnabled(false);
+	oSocketTick.SetTickFunctionEnable(false);
+
+	return true;
+}
+
+void AHackNSlacksCharacter::Revive()
+{
+	if (eDeathStage == EDeathStage::Alive)
+		return;
+
+	if (FDeathQueue* poDeaths = FDeathQueue::Get(GetWorld()))
+		poDeaths->Remove(this);
+
+	if (eDeathStage == EDeathStage::Corpse)
+	{
+		StopDeathRagdoll();
+
+		SetActorTickEnabled(true);
+		oSocketTick.SetTickFunctionEnable(true);
+	}
+
+	if (AAIController* pkAI = Cast<AAIController>(Controller))
+		if (pkAI->BrainComponent)
+			pkAI->BrainComponent->ResumeLogic(TEXT("Death"));
+
+	eDeathStage = EDeathStage::Alive;
+}
+
+void AHackNSlacksCharacter::StopBuffs()
 {
 	for (int32 iBuff = 0; iBuff < aoBuffs.Num(); iBuff++)
 	{
@@ -372,54 +753,249 @@ void AHackNSlacksCharacter::OnDeath()
 	}
 }
 
+void AHackNSlacksCharacter::StartDeathRagdoll()
+{
+	GetCharacterMovement()->DisableMovement();
+
+	eCapsuleCollisionBeforeRagdoll = GetCapsuleComponent()->GetCollisionEnabled();
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	USkeletalMeshComponent* pkSkeleton = GetMesh();
+
+	sMeshProfileBeforeRagdoll = pkSkeleton->GetCollisionProfileName();
+	pkSkeleton->SetCollisionProfileName(FHNSNames::Ragdoll);
+	pkSkeleton->SetSimulatePhysics(true);
+}
+
+void AHackNSlacksCharacter::StopDeathRagdoll()
+{
+	USkeletalMeshComponent* pkSkeleton = GetMesh();
+
+	pkSkeleton->SetSimulatePhysics(false);
+	pkSkeleton->SetCollisionProfileName(sMeshProfileBeforeRagdoll);
+
+	// the simulated mesh drifted away from the capsule
+	pkSkeleton->AttachTo(GetCapsuleComponent(), NAME_None, EAttachLocation::SnapToTarget);
+	pkSkeleton->SetRelativeLocationAndRotation(BaseTranslationOffset, BaseRotationOffset);
+
+	GetCapsuleComponent()->SetCollisionEnabled(eCapsuleCollisionBeforeRagdoll);
+
+	GetCharacterMovement()->SetDefaultMovementMode();
+}
+
+bool AHackNSlacksCharacter::UsesDeathQueue() const
+{
+	return true;
+}
+
 void AHackNSlacksCharacter::OnDestroy()
 {
-	OnDeath();
+	// queued deaths and corpses stopped their buffs when they died
+	if (eDeathStage == EDeathStage::Alive)
+		StopBuffs();
+
+	// pooled weapons go back to the pool instead of being left behind
+	FWeaponPool* poPool = FWeaponPool::Get(GetWorld());
+
+	if (poPool && poPool->Owns(pkWeapon))
+	{
+		AWeapon* pkPooled = pkWeapon;
+
+		pkPooled->Drop();
+		pkWeapon = nullptr;
+
+		poPool->Release(pkPooled);
+	}
+}
+
+void AHackNSlacksCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// blueprints can add these, so they may not have been set in the constructor
+	if (!pkCameraFollow)
+		pkCameraFollow = FindComponentByClass<UCameraFollowComponent>();
+
+	if (!pkInventory)
+		pkInventory = FindComponentByClass<UCharacterInventoryComponent>();
 }
 
 void AHackNSlacksCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	pkCharAnim = Cast<UCharacterAnimInstance>(GetMesh()->GetAnimInstance());
+	eInitStage = ESpawnInitStage::Anim;
 
-	pkAttackDict = UAttackDictionary::GetManager(pkAttackDictClass);
+	// set at spawn so state restored before the init queue finishes, e.g. from a checkpoint, is kept
+	fHealth = fMaxHealth;
+
+	if (ShouldTimeSliceInit())
+	{
+		// stay inactive until the queue reaches the last stage
+		bHiddenBeforeInit = bHidden;
+		bCollisionBeforeInit = GetActorEnableCollision();
+
+		SetActorHiddenInGame(true);
+		SetActorEnableCollision(false);
+		SetActorTickEnabled(false);
 
+		if (UCharacterMovementComponent* pkCharMovement = GetCharacterMovement())
+			pkCharMovement->SetComponentTickEnabled(false);
+
+		if (AAIController* pkAI = Cast<AAIController>(Controller))
+			if (pkAI->BrainComponent)
+				pkAI->BrainComponent->PauseLogic(TEXT("SpawnInit"));
+
+		FSpawnInitQueue::Get().Add(this);
+	}
+	else
+	{
+		while (!RunInitStage());
+	}
+}
+
+bool AHackNSlacksCharacter::ShouldTimeSliceInit() const
+{
+	return true;
+}
+
+bool AHackNSlacksCharacter::RunInitStage()
+{
 	USkeletalMeshComponent* pkSkeleton = GetMesh();
 
-	for (int32 iSocket = 0; iSocket < (int32)EBodyParts::Count; iSocket++)
-		apoSockets[iSocket].Init(pkSkeleton);
+	switch (eInitStage)
+	{
+	case ESpawnInitStage::Anim:
+	{
+		pkCharAnim = Cast<UCharacterAnimInstance>(pkSkeleton->GetAnimInstance());
 
-	// get body part colliders
-	GetComponents<UAttackCollider>(apkAttackColliders);
+		pkAttackDict = UAttackDictionary::GetManager(pkAttackDictClass);
 
-	// fill in missing parts
-	while (apkAttackColliders.Num() < (int32)EBodyParts::Count)
-		apkAttackColliders.Add(nullptr);
+		// attacks are replicated and found in the cooked attack data by their registration
+		FCombatNetDictionaries::Get().RegisterAttacks(pkAttackDict);
 
-	// sort colliders to match the enum
-	for (int32 iCollider = 0; iCollider < apkAttackColliders.Num(); iCollider++)
+		// bake root motion with the dictionary instead of on an attack's first swing
+		FAttackVelocityTrack::BakeDictionary(pkAttackDict);
+		break;
+	}
+	case ESpawnInitStage::Sockets:
 	{
-		UAttackCollider* pkTemp = apkAttackColliders[iCollider];
+		for (int32 iSocket = 0; iSocket < (int32)EBodyParts::Count; iSocket++)
+			apoSockets[iSocket].Init(pkSkeleton);
 
-		if (!pkTemp)
-			continue;
+		CacheSocketBones();
+		break;
+	}
+	case ESpawnInitStage::Colliders:
+	{
+		// get body part colliders
+		GetComponents<UAttackCollider>(apkAttackColliders);
+
+		// fill in missing parts
+		while (apkAttackColliders.Num() < (int32)EBodyParts::Count)
+			apkAttackColliders.Add(nullptr);
+
+		// sort colliders to match the enum
+		for (int32 iCollider = 0; iCollider < apkAttackColliders.Num(); iCollider++)
+		{
+			UAttackCollider* pkTemp = apkAttackColliders[iCollider];
+
+			if (!pkTemp)
+				continue;
 
-		int32 iBodyPart = (int32)pkTemp->eBodyPart;
+			int32 iBodyPart = (int32)pkTemp->eBodyPart;
 
-		apkAttackColliders[iCollider] = apkAttackColliders[iBodyPart];
-		apkAttackColliders[iBodyPart] = pkTemp;
+			apkAttackColliders[iCollider] = apkAttackColliders[iBodyPart];
+			apkAttackColliders[iBodyPart] = pkTemp;
+		}
+		break;
 	}
+	case ESpawnInitStage::Weapon:
+	{
+		// create starting weapon if assigned, reusing a pooled one when there is one free - the level's AWeaponPoolSettings fills the pool
+		if (oSpawnWithWeapon.eWeaponType != EWeaponTypes::Count)
+		{
+			AWeapon* pkWeap = nullptr;
 
-	// create starting weapon if assigned
-	if (oSpawnWithWeapon.eWeaponType != EWeaponTypes::Count)
-		if (AWeapon* pkWeap = oSpawnWithWeapon.SpawnWeapon())
-			pkWeap->PickUp(this);
-	
-	//if (pkSkeleton && pkCharAnim)
-	//	pkCharAnim->oBaseHeadRot = pkSkeleton->GetSocketTransform("head").Rotator();
+			if (FWeaponPool* poPool = FWeaponPool::Get(GetWorld()))
+				pkWeap = poPool->Acquire(oSpawnWithWeapon);
+			else
+				pkWeap = oSpawnWithWeapon.SpawnWeapon();
 
-	fHealth = fMaxHealth;
+			if (pkWeap)
+				pkWeap->PickUp(this);
+		}
+		break;
+	}
+	case ESpawnInitStage::Activate:
+	{
+		//if (pkSkeleton && pkCharAnim)
+		//	pkCharAnim->oBaseHeadRot = pkSkeleton->GetSocketTransform("head").Rotator();
+
+		// one mesh for the body and its gear
+		RequestMeshMerge();
+
+		// only react to attacks started after spawning
+		if (FAttackEventBuffer* poAttackEvents = FAttackEventBuffer::Get(GetWorld()))
+			iAttackEventCursor = poAttackEvents->GetHead();
+
+		// the closest item only drives the pick up prompt, a few frames late is fine
+		if (pkInventory)
+			FDeferredTaskScheduler::Get().Register(this, FDeferredTask::CreateUObject(this, &AHackNSlacksCharacter::UpdateClosestItem), 0, 0.2f);
+
+		if (ShouldTimeSliceInit())
+		{
+			SetActorHiddenInGame(bHiddenBeforeInit);
+			SetActorEnableCollision(bCollisionBeforeInit);
+			SetActorTickEnabled(true);
+
+			if (UCharacterMovementComponent* pkCharMovement = GetCharacterMovement())
+				pkCharMovement->SetComponentTickEnabled(true);
+
+			if (AAIController* pkAI = Cast<AAIController>(Controller))
+				if (pkAI->BrainComponent)
+					pkAI->BrainComponent->ResumeLogic(TEXT("SpawnInit"));
+		}
+
+		eInitStage = ESpawnInitStage::Done;
+
+		OnInitialized();
+		return true;
+	}
+	case ESpawnInitStage::Done:
+		return true;
+	}
+
+	eInitStage = (ESpawnInitStage)((uint8)eInitStage + 1);
+
+	return false;
+}
+
+void AHackNSlacksCharacter::OnInitialized()
+{
+}
+
+void AHackNSlacksCharacter::RegisterActorTickFunctions(bool bRegister)
+{
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (oSocketTick.bCanEverTick && !IsTemplate())
+		{
+			oSocketTick.pkTarget = this;
+			oSocketTick.SetTickFunctionEnable(oSocketTick.bStartWithTickEnabled);
+			oSocketTick.RegisterTickFunction(GetLevel());
+
+			// wait for the mesh to finish animating this frame
+			if (USkeletalMeshComponent* pkSkeleton = GetMesh())
+				oSocketTick.AddPrerequisite(pkSkeleton, pkSkeleton->PrimaryComponentTick);
+		}
+	}
+	else if (oSocketTick.IsTickFunctionRegistered())
+	{
+		oSocketTick.UnRegisterTickFunction();
+	}
 }
 
 // character update
@@ -431,87 +1007,201 @@ void AHackNSlacksCharacter::TickActor(float DeltaTime, enum ELevelTick TickType,
 
 	UpdateBuffs();
 
-	CameraFollow(DeltaTime);
+	// buffs and inventory records are added from many places, check their size once a tick
+	oBuffsMemory.Update(aoBuffs.GetAllocatedSize());
+
+	if (pkInventory)
+		pkInventory->oRecordsMemory.Update(pkInventory->oInventory.aoRecords.GetAllocatedSize());
+
+	StepCombat(DeltaTime);
+
+	// velocity and charge aim follow the timers between steps, once a frame since movement only moves once a frame
+	if (oHot.poCurrentAttack)
+	{
+		if (oHot.bCharging)
+			UpdateCharge(oHot.poCurrentAttack, pkCharAnim);
+		else
+			AttackMove(oHot.poCurrentAttack);
+	}
+
+	if (!oHot.bDodging && !oHot.poCurrentAttack && pkCharAnim && pkCharAnim->bHasTargetAngle)
+		pkCharAnim->bHasTargetAngle = false;
+}
+
+void AHackNSlacksCharacter::CancelAttack()
+{
+	if (!oHot.poCurrentAttack)
+		return;
+
+	bPendingAttackCancel = true;
+	iAttacksAtCancel = iAttacksStarted;
+}
+
+int32 AHackNSlacksCharacter::StepCombat(float DeltaTime)
+{
+	oHot.fCombatAccumulator += DeltaTime;
+
+	int32 iSteps = 0;
+
+	while (oHot.fCombatAccumulator >= CombatStepTime && iSteps < MaxCombatSteps)
+	{
+		oHot.fCombatAccumulator -= CombatStepTime;
+
+		TickCombat(CombatStepTime);
+		OnCombatStep(CombatStepTime);
+
+		iSteps++;
+	}
+
+	// hitch longer than the steps allowed, keep only the part of a step
+	if (oHot.fCombatAccumulator >= CombatStepTime)
+	{
+		float fKept = FMath::Fmod(oHot.fCombatAccumulator, CombatStepTime);
+
+		GCappedCombatFrames++;
+		GDroppedCombatTime += oHot.fCombatAccumulator - fKept;
+
+		oHot.fCombatAccumulator = fKept;
+	}
+
+	GCombatSteps += iSteps;
+
+	return iSteps;
+}
+
+void AHackNSlacksCharacter::ReportCombatSteps()
+{
+	double fNow = FPlatformTime::Seconds();
+
+	if (GCombatStepsSince > 0.0)
+		UE_LOG(LogTemp, Log, TEXT("Combat steps: %lld run in %.1f s, %d character frames hit the limit of %d and dropped %.3f s of combat time"), GCombatSteps, fNow - GCombatStepsSince, GCappedCombatFrames, MaxCombatSteps, GDroppedCombatTime);
+
+	GCombatSteps = 0;
+	GCappedCombatFrames = 0;
+	GDroppedCombatTime = 0.0;
+	GCombatStepsSince = fNow;
+}
+
+void AHackNSlacksCharacter::OnCombatStep(float fStepTime)
+{
+
+}
+
+float AHackNSlacksCharacter::GetComboTimer() const
+{
+	// the combo timer only runs while an uncharged attack does
+	if (!oHot.poCurrentAttack || oHot.bCharging)
+		return oHot.fComboTimer;
+
+	return oHot.fComboTimer + oHot.fCombatAccumulator;
+}
+
+float AHackNSlacksCharacter::GetChargeTimer() const
+{
+	if (!oHot.bCharging || !oHot.poCurrentRecord)
+		return oHot.fChargeTimer;
+
+	return FMath::Min(oHot.fChargeTimer + oHot.fCombatAccumulator, oHot.poCurrentRecord->fMaxCharge);
+}
+
+// advance combo, charge and dodge timers by one fixed step - also used to replay predicted steps
+void AHackNSlacksCharacter::TickCombat(float DeltaTime)
+{
+	// replays leave the cancel to the next real step
+	if (bPendingAttackCancel && !oHot.bReplayingPrediction)
+	{
+		bPendingAttackCancel = false;
+
+		if (oHot.poCurrentAttack && iAttacksStarted == iAttacksAtCancel)
+			ResetCombo();
+	}
 
 	// character is attacking
-	if (poCurrentAttack)
+	if (oHot.poCurrentAttack)
 	{
 		// attack is a chargable attack
-		if (bCharging)
+		if (oHot.bCharging)
 		{
-			fChargeTimer += DeltaTime;
-
-			UpdateCharge(poCurrentAttack, pkCharAnim);
+			oHot.fChargeTimer += DeltaTime;
 
 			// attack has reached max charge
-			if (fChargeTimer >= poCurrentAttack->fMaxCharge)
+			if (oHot.fChargeTimer >= oHot.poCurrentRecord->fMaxCharge)
 				EndCharge();
 		}
-		else if (fComboTimer > poCurrentAttack->fEndComboWait)
+		else if (oHot.fComboTimer > oHot.poCurrentRecord->fEndComboWait)
 			ResetCombo();
 		else
 		{
-			fComboTimer += DeltaTime;
-
-			AttackMove(poCurrentAttack);
+			oHot.fComboTimer += DeltaTime;
 		}
 	}
 
-	if (!bDodging && iDodgeCount > 0)
+	if (!oHot.bDodging && oHot.iDodgeCount > 0)
 	{
-		fDodgeLockTimer += DeltaTime;
+		oHot.fDodgeLockTimer += DeltaTime;
 		
-		if (fDodgeLockTimer >= fDodgeLockDuration)
+		if (oHot.fDodgeLockTimer >= fDodgeLockDuration)
 		{
-			iDodgeCount = 0;
-			fDodgeLockTimer = 0.0f;
+			oHot.iDodgeCount = 0;
+			oHot.fDodgeLockTimer = 0.0f;
 		}
 	}
-
-	if (!bDodging && !poCurrentAttack && pkCharAnim && pkCharAnim->bHasTargetAngle)
-		pkCharAnim->bHasTargetAngle = false;
-
-	GetClosestItem();
 }
 
 /*void AHackNSlacksCharacter::Jump()
 {
 	Super::Jump();
 
-	bOnGround = false;
+	oHot.bOnGround = false;
 }*/
 
 /*void AHackNSlacksCharacter::Falling()
 {
 	Super::Falling();
 
-	bOnGround = false;
+	oHot.bOnGround = false;
 }*/
 
 /*void AHackNSlacksCharacter::Landed(const FHitResult& Hit)
 {
 	Super::Landed(Hit);
 
-	bOnGround = true;
+	oHot.bOnGround = true;
 }*/
 
-/*void AHackNSlacksCharacter::OnLightAttack()
+void AHackNSlacksCharacter::OnLightAttack()
 {
 	PerformAttack(EPlayerInputs::LightAttack);
-} */
+}
 
-/*void AHackNSlacksCharacter::OnHeavyAttack()
+void AHackNSlacksCharacter::OnHeavyAttack()
 {
 	PerformAttack(EPlayerInputs::HeavyAttack);
-}*/
+}
 
 void AHackNSlacksCharacter::AttackMove(FAttackEntry* poAttackEntry)
 {
-	FRotator oActorRotation = GetActorRotation();
+	UCharacterMovementComponent* pkCharMovement = GetCharacterMovement();
+
+	// baked root motion is sampled by the combo timer between steps, in the mesh's space - the combo timer runs at the
+	// attack's play rate, charged attacks included
+	if (const FAttackVelocityTrack* poTrack = FAttackVelocityTrack::FindOrBake(poAttackEntry))
+	{
+		FQuat oMeshRotation = GetMesh()->GetComponentQuat();
 
-	FVector oLocalVelocity = oActorRotation.UnrotateVector(GetCharacterMovement()->Velocity);
+		FVector oLocalVelocity = oMeshRotation.UnrotateVector(pkCharMovement->Velocity);
+
+		pkCharMovement->Velocity = oMeshRotation.RotateVector(poTrack->Evaluate(oLocalVelocity, GetComboTimer() * poAttackEntry->fPlayRate, poAttackEntry->fPlayRate));
+	}
+	// animations without root motion drive movement through the anim instance
+	else if (pkCharAnim)
+	{
+		FRotator oActorRotation = GetActorRotation();
 
-	GetCharacterMovement()->Velocity = oActorRotation.RotateVector(pkCharAnim->GetAnimVelocity(oLocalVelocity));
+		FVector oLocalVelocity = oActorRotation.UnrotateVector(pkCharMovement->Velocity);
+
+		pkCharMovement->Velocity = oActorRotation.RotateVector(pkCharAnim->GetAnimVelocity(oLocalVelocity));
+	}
 }
 
 void AHackNSlacksCharacter::UpdateCharge(FAttackEntry* poAttackEntry, UCharacterAnimInstance* pkCharAnim)
@@ -526,52 +1216,70 @@ void AHackNSlacksCharacter::OnEndCharge(FAttackEntry* poAttackEntry, UCharacterA
 
 void AHackNSlacksCharacter::EndCharge()
 {
-	if (bCharging)
+	if (oHot.bCharging)
 	{
-		bCharging = false;
+		oHot.bCharging = false;
+
+		// the charge played the animation at fPlayRate * 0.1 / fMaxCharge, see DoAttack - start the combo timer where that
+		// left the animation, in the same units as an uncharged attack so the animation is at fComboTimer * fPlayRate
+		if (oHot.poCurrentAttack)
+			oHot.fComboTimer = oHot.fChargeTimer * 0.1f / oHot.poCurrentAttack->fMaxCharge;
+
+		// replayed frames only rebuild timers, the release already played when it was predicted
+		if (oHot.bReplayingPrediction)
+		{
+			oHot.fChargeTimer = 0.0f;
+
+			return;
+		}
 
-		pkWeapon->fCharge = fChargeTimer;
+		pkWeapon->fCharge = oHot.fChargeTimer;
 
-		if (poCurrentAttack)
+		if (oHot.poCurrentAttack)
 		{
 			if (pkCharAnim)
 			{
-				// set timer to match the position of the animation
-				fComboTimer = fChargeTimer * pkCharAnim->Montage_GetPlayRate(pkCharAnim->pkCurrentAttackAnim);
-
-				pkCharAnim->Montage_SetPlayRate(pkCharAnim->pkCurrentAttackAnim, poCurrentAttack->fPlayRate);
+				pkCharAnim->Montage_SetPlayRate(pkCharAnim->pkCurrentAttackAnim, oHot.poCurrentAttack->fPlayRate);
 
-				OnEndCharge(poCurrentAttack, pkCharAnim);
+				OnEndCharge(oHot.poCurrentAttack, pkCharAnim);
 			}
 
-			poCurrentAttack->OnAttack(this, fChargeTimer);
+			oHot.poCurrentAttack->OnAttack(this, oHot.fChargeTimer);
 		}
 
-		fChargeTimer = 0.0f;
+		oHot.fChargeTimer = 0.0f;
 	}
 }
 
-/*void AHackNSlacksCharacter::OnPerformAttack(FAttackEntry* poAttackEntry, UCharacterAnimInstance* pkCharAnim, float fPlayRate)
+void AHackNSlacksCharacter::OnPerformAttack(FAttackEntry* poAttackEntry, UCharacterAnimInstance* pkCharAnim, float fPlayRate)
 {
 	pkCharAnim->SetAnim(poAttackEntry->eBodyPose, poAttackEntry->pkAttackAnim, fPlayRate, true);
-}*/
+}
 
-/*void AHackNSlacksCharacter::PerformAttack(EPlayerInputs eInput)
+void AHackNSlacksCharacter::PerformAttack(EPlayerInputs eInput)
 {
-	if (!bDodging && pkWeapon && pkWeapon->GetAttackDictionary()->DoAttack(poCurrentAttack, eInput, fComboTimer, bSprinting, !bOnGround))
+	if (!oHot.bDodging && pkWeapon && pkWeapon->GetAttackDictionary()->DoAttack(oHot.poCurrentAttack, eInput, oHot.fComboTimer, oHot.bSprinting, !oHot.bOnGround))
 	{
-		DoAttack(poCurrentAttack);
-		iCurrentAttack = poCurrentAttack->iAIAppropsResponse;
+		DoAttack(oHot.poCurrentAttack);
+		iCurrentAttack = oHot.poCurrentAttack->iAIAppropsResponse;
 	}
-}*/
+}
 
 void AHackNSlacksCharacter::DoAttack(FAttackEntry* poAttackEntry)
 {
 	if (poAttackEntry)
 	{
-		fComboTimer = 0.0f;
+		oHot.fComboTimer = 0.0f;
+
+		SetCurrentAttack(poAttackEntry);
 
-		poCurrentAttack = poAttackEntry;
+		oHot.bCharging = poAttackEntry->fMaxCharge > 0.0f;
+
+		// replayed frames only rebuild timers, the attack already played when it was predicted
+		if (oHot.bReplayingPrediction)
+			return;
+
+		iAttacksStarted++;
 
 		pkWeapon->fCharge = 0.0f;
 
@@ -579,71 +1287,98 @@ void AHackNSlacksCharacter::DoAttack(FAttackEntry* poAttackEntry)
 			if ((*pkIter))
 				(*pkIter)->SetColliderActive(false);
 
-		bCharging = poAttackEntry->fMaxCharge > 0.0f;
+		EndAttackSweeps();
 
 		poAttackEntry->OnAttack(this);
 
-		if (!bCharging)
+		if (!oHot.bCharging)
 			AttackMove(poAttackEntry);
 
 		if (pkCharAnim)
 		{
 			// need to set animation speed for charged attacks
-			if (bCharging)
+			if (oHot.bCharging)
 				OnPerformAttack(poAttackEntry, pkCharAnim, poAttackEntry->fPlayRate * 0.1f / poAttackEntry->fMaxCharge);
 			else
 				OnPerformAttack(poAttackEntry, pkCharAnim, poAttackEntry->fPlayRate);
 		}
+
+		PublishAttackEvent(poAttackEntry);
 	}
 }
 
-void AHackNSlacksCharacter::BeginOverlap(class AActor* pkOtherActor)
+void AHackNSlacksCharacter::SetCurrentAttack(FAttackEntry* poAttack)
 {
+	oHot.poCurrentAttack = poAttack;
+	oHot.poCurrentRecord = poAttack ? FAttackDataBlob::FindRecord(poAttack) : nullptr;
 
-}
-
-void AHackNSlacksCharacter::EndOverlap(class AActor* pkOtherActor)
-{
+	if (!poAttack)
+		return;
 
+	// not cooked yet or cooked from older data, copy the entry
+	if (!oHot.poCurrentRecord)
+	{
+		FAttackRecord::Make(*poAttack, oUncookedRecord);
+		oHot.poCurrentRecord = &oUncookedRecord;
+	}
 }
 
-void AHackNSlacksCharacter::GetClosestItem()
+void AHackNSlacksCharacter::PublishAttackEvent(FAttackEntry* poAttackEntry)
 {
-	pkClosestItem = nullptr;
+	FAttackEventBuffer* poAttackEvents = FAttackEventBuffer::Get(GetWorld());
 
-	if (apkNearbyItems.Num() == 0)
+	if (!poAttackEvents)
 		return;
 
-	auto pkItemIter = apkNearbyItems.GetHead();
+	FAttackEvent oEvent;
 
-	pkClosestItem = ((pkItemIter->GetValue()!= NULL)?pkItemIter->GetValue():nullptr);
+	oEvent.pkAttacker = this;
+	oEvent.poAttackEntry = poAttackEntry;
+	oEvent.iAIResponse = poAttackEntry->iAIAppropsResponse;
+	oEvent.oLocation = GetActorLocation();
+	oEvent.bCharging = oHot.bCharging;
 
-	if (pkClosestItem == nullptr || !pkClosestItem->IsValidLowLevel()) return;
+	// directional attacks turn towards their target during the animation
+	oEvent.oDirection = pkCharAnim && pkCharAnim->bHasTargetAngle ? pkCharAnim->oTargetRot.Vector() : GetActorForwardVector();
 
-	float fClosestDistSQ = FVector::DistSquared(pkClosestItem->GetActorLocation(), GetActorLocation());
+	oEvent.fStartTime = GetWorld()->GetTimeSeconds();
+	oEvent.fActiveEndTime = oEvent.fStartTime + (oHot.bCharging ? poAttackEntry->fMaxCharge : 0.0f);
 
-	while ((pkItemIter = pkItemIter->GetNextNode()) != nullptr)
-	{
-		AItem* pkItem = pkItemIter->GetValue();
+	if (poAttackEntry->pkAttackAnim && poAttackEntry->fPlayRate > 0.0f)
+		oEvent.fActiveEndTime += poAttackEntry->pkAttackAnim->SequenceLength / poAttackEntry->fPlayRate;
 
-		float fDistSQ = FVector::DistSquared(pkItem->GetActorLocation(), GetActorLocation());
+	poAttackEvents->Publish(oEvent);
+}
 
-		if (fDistSQ < fClosestDistSQ)
-		{
-			pkClosestItem = pkItem;
-			fClosestDistSQ = fDistSQ;
-		}
-	}
+void AHackNSlacksCharacter::BeginOverlap(class AActor* pkOtherActor)
+{
+
+}
+
+void AHackNSlacksCharacter::EndOverlap(class AActor* pkOtherActor)
+{
+
+}
+
+void AHackNSlacksCharacter::GetClosestItem()
+{
+	if (pkInventory)
+		pkInventory->UpdateClosestItem(GetActorLocation());
+}
+
+void AHackNSlacksCharacter::UpdateClosestItem(float fElapsed)
+{
+	GetClosestItem();
 }
 
 /*AChest* AHackNSlacksCharacter::GetClosestOpenableChest()
 {
-	if (apkNearbyChests.Num() == 0)
+	if (!pkInventory || pkInventory->apkNearbyChests.Num() == 0)
 		return nullptr;
 
 	AChest* pkClosestChest = nullptr;
 
-	auto pkChestIter = apkNearbyChests.GetHead();
+	auto pkChestIter = pkInventory->apkNearbyChests.GetHead();
 
 	float fClosestDistSQ = 0.0f;
 
@@ -670,14 +1405,18 @@ void AHackNSlacksCharacter::GetClosestItem()
 
 void AHackNSlacksCharacter::ResetCombo()
 {
-	GetCharacterMovement()->MovementMode = EMovementMode::MOVE_Walking;
+	oHot.fComboTimer = 0.0f;
+	oHot.fChargeTimer = 0.0f;
 
-	fComboTimer = 0.0f;
-	fChargeTimer = 0.0f;
+	oHot.bCharging = false;
 
-	bCharging = false;
+	SetCurrentAttack(nullptr);
 
-	poCurrentAttack = nullptr;
+	// replayed frames only rebuild the combo state, the reconcile fixes up movement and animation once it is done
+	if (oHot.bReplayingPrediction)
+		return;
+
+	GetCharacterMovement()->MovementMode = EMovementMode::MOVE_Walking;
 
 	if (pkCharAnim)
 	{
@@ -688,54 +1427,86 @@ void AHackNSlacksCharacter::ResetCombo()
 	for (TArray<UAttackCollider*>::TIterator pkIter = apkAttackColliders.CreateIterator(); pkIter; ++pkIter)
 		if ((*pkIter))
 			(*pkIter)->SetColliderActive(false);
+
+	EndAttackSweeps();
 }
 
-void AHackNSlacksCharacter::CameraFollow(float DeltaTime)
+void AHackNSlacksCharacter::ReportFootprint()
 {
-	if (bIsLockedOn == false && bDisableAutoCameraFollow == false)
-	{
-		FRotator PlayerRotator = GetControlRotation();
-		FRotator TempYawRotator;
+	UE_LOG(LogTemp, Log, TEXT("AHackNSlacksCharacter: %d bytes, hot state %d bytes at offset %d"), (int32)sizeof(AHackNSlacksCharacter), (int32)sizeof(FCharacterHotState), (int32)STRUCT_OFFSET(AHackNSlacksCharacter, oHot));
 
-		// Getting Yaw as that is the only axis to rotate
-		TempYawRotator.Yaw = PlayerRotator.Yaw; TempYawRotator.Pitch = 0; TempYawRotator.Roll = 0;
-
-		FVector ForwardVector = FRotationMatrix(TempYawRotator).GetUnitAxis(EAxis::X) * GetInputAxisValue("MoveForward");
-		FVector RightVector = FRotationMatrix(TempYawRotator).GetUnitAxis(EAxis::Y) * GetInputAxisValue("MoveRight");
+	struct FClassFootprint
+	{
+		FClassFootprint() : iCount(0), iObjectBytes(0), iComponentBytes(0), iHeapBytes(0) {}
 
-		FVector MoveDirection = ForwardVector + RightVector;
-		MoveDirection.Normalize();
+		int32 iCount;
+		int64 iObjectBytes;
+		int64 iComponentBytes;
+		int64 iHeapBytes;
+	};
 
-		FRotator XVecRotator = MoveDirection.Rotation();
-		GetControlRotation();
+	TMap<UClass*, FClassFootprint> kFootprints;
 
-		/*DeltaRotator is MoveDirections Rotation - Controllers rotation then normalised*/
-		FRotator DeltaRotator = XVecRotator - GetControlRotation();
-		DeltaRotator.Normalize();
+	for (TObjectIterator<AHackNSlacksCharacter> pkIter; pkIter; ++pkIter)
+	{
+		AHackNSlacksCharacter* pkCharacter = *pkIter;
 
-		float InputLength = FMath::Abs(GetInputAxisValue("MoveForward")) + FMath::Abs(GetInputAxisValue("MoveRight"));
-		FMath::Clamp(InputLength, 0.f, 1.0f);
+		if (pkCharacter->IsTemplate() || pkCharacter->IsPendingKill())
+			continue;
 
+		FClassFootprint& oFootprint = kFootprints.FindOrAdd(pkCharacter->GetClass());
 
-		FVector ControllerForwardVec = FRotationMatrix(TempYawRotator).GetUnitAxis(EAxis::X);
+		oFootprint.iCount++;
+		oFootprint.iObjectBytes += pkCharacter->GetClass()->GetPropertiesSize();
 
-	
+		TArray<UActorComponent*> apkComponents;
+		pkCharacter->GetComponents(apkComponents);
 
-		float CameraMoveDotProd = FVector::DotProduct(ControllerForwardVec, MoveDirection);
+		for (UActorComponent* pkComponent : apkComponents)
+			oFootprint.iComponentBytes += pkComponent->GetClass()->GetPropertiesSize();
 
-		CameraMoveDotProd = 1 - FMath::Abs(CameraMoveDotProd);
+		oFootprint.iHeapBytes += pkCharacter->aoBuffs.GetAllocatedSize() + pkCharacter->apkAttackColliders.GetAllocatedSize() + pkCharacter->aoSimulatingBodies.Num() * sizeof(FSimulatingBody);
 
-		float FirstStep = InputLength * DeltaTime * FMath::Pow(CameraMoveDotProd, fAngleInfluence) * fCameraRotRate;
-		FMath::Clamp(FirstStep, 0.f, 1.0f);
-		AddControllerYawInput(FirstStep * DeltaRotator.Yaw);
+		// list nodes hold a value and two links
+		if (pkCharacter->pkInventory)
+			oFootprint.iHeapBytes += pkCharacter->pkInventory->oInventory.aoRecords.GetAllocatedSize()
+				+ (pkCharacter->pkInventory->apkNearbyItems.Num() + pkCharacter->pkInventory->apkNearbyChests.Num()) * sizeof(void*) * 3;
 	}
 
+	for (auto& kFootprint : kFootprints)
+	{
+		const FClassFootprint& oFootprint = kFootprint.Value;
 
-	
+		UE_LOG(LogTemp, Log, TEXT("%s x%d: %lld object + %lld component + %lld heap bytes each"), *kFootprint.Key->GetName(), oFootprint.iCount,
+			oFootprint.iObjectBytes / oFootprint.iCount, oFootprint.iComponentBytes / oFootprint.iCount, oFootprint.iHeapBytes / oFootprint.iCount);
+	}
 }
 
 void AHackNSlacksCharacter::ResetCurrentAttackRef()
 {
 	iCurrentAttack = 0;
 
+}
+
+int32 AHackNSlacksCharacter::ReadAttackEvents(float fRadius, TArray<FAttackEvent>& aoEvents)
+{
+	FAttackEventBuffer* poAttackEvents = FAttackEventBuffer::Get(GetWorld());
+
+	if (!poAttackEvents)
+		return 0;
+
+	int32 iFirst = aoEvents.Num();
+
+	poAttackEvents->Read(iAttackEventCursor, GetActorLocation(), fRadius, aoEvents);
+
+	// ignore own and allied attacks
+	for (int32 iEvent = aoEvents.Num() - 1; iEvent >= iFirst; iEvent--)
+	{
+		AHackNSlacksCharacter* pkAttacker = aoEvents[iEvent].pkAttacker.Get();
+
+		if (!pkAttacker || pkAttacker == this || pkAttacker->eTeam == eTeam)
+			aoEvents.RemoveAt(iEvent, 1, false);
+	}
+
+	return aoEvents.Num() - iFirst;
 }
\ No newline at end of file
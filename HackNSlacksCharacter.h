@@ -8,6 +8,13 @@
 #include "Buff.h"
 #include "SimulatingBody.h"
 #include "WeaponSpawn.h"
+#include "CharacterHotState.h"
+#include "AttackDataBlob.h"
+#include "SpawnInitQueue.h"
+#include "DeathQueue.h"
+#include "CombatMemory.h"
+#include "AttackEventBuffer.h"
+#include "SocketTransformTick.h"
 #include "GameFramework/Character.h"
 #include "HackNSlacksCharacter.generated.h"
 
@@ -21,12 +28,18 @@ class AChest;
 class UCharacterAnimInstance;
 struct FAttackEntry;
 class UAbility;
+class UCameraFollowComponent;
+class UCharacterInventoryComponent;
 
 UCLASS(config=Game)
 class AHackNSlacksCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	friend struct FCheckpointSnapshot;
+	friend struct FCombatNetState;
+	friend struct FPredictedCombatState;
+
 public:
 	AHackNSlacksCharacter(const FObjectInitializer& ObjectInitializer);
 
@@ -36,15 +49,70 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Weapon)
 	AWeapon* GetWeapon();
 
+	// null for characters without a follow camera
+	UFUNCTION(BlueprintCallable, Category = Camera)
+	UCameraFollowComponent* GetCameraFollow() const { return pkCameraFollow; }
+
+	// null for characters that do not pick up items
+	UFUNCTION(BlueprintCallable, Category = Item)
+	UCharacterInventoryComponent* GetInventory() const { return pkInventory; }
+
+	// combo timer between combat steps, for drawing and animation - combat itself only sees whole steps
+	UFUNCTION(BlueprintCallable, Category = Attack)
+	float GetComboTimer() const;
+
+	// charge timer between combat steps
+	UFUNCTION(BlueprintCallable, Category = Attack)
+	float GetChargeTimer() const;
+
+	// how far the frame is between the last combat step and the next, 0 to 1
+	UFUNCTION(BlueprintCallable, Category = Attack)
+	float GetCombatAlpha() const { return oHot.fCombatAccumulator / CombatStepTime; }
+
+	// combat timers advance in fixed steps of this many seconds whatever the frame rate, so results do not depend on it
+	static const float CombatStepTime;
+
+	// most combat steps run in one frame - time past them is dropped so a long hitch does not skip windows over several frames, HNS.CombatSteps reports how much
+	static const int32 MaxCombatSteps;
+
+	UFUNCTION(BlueprintCallable, Category = Dodge)
+	bool IsDodging() const { return oHot.bDodging; }
+
+	UFUNCTION(BlueprintCallable, Category = Player)
+	bool IsSprinting() const { return oHot.bSprinting; }
+
 	// get the bone or socket that represents a body part that gear can be attached to
 	const USkeletalMeshSocket* GetBoneSocket(EBodyParts eBodyPart);
 
+	// world transform of a body part socket this frame, cached once the mesh has animated - identity if the socket is not set
+	const FTransform& GetSocketTransform(EBodyParts eBodyPart) const { return aoSocketTransforms[(int32)eBodyPart]; }
+
+	// false if the body part has no socket
+	bool HasSocket(EBodyParts eBodyPart) const { return aiSocketBones[(int32)eBodyPart] != INDEX_NONE; }
+
+	// highest cached body part socket, falls back to the top of the capsule
+	FVector GetTopSocketLocation() const;
+
+	// cache the world transforms of all body part sockets, called by the post animation tick
+	void UpdateSocketTransforms();
+
 	UFUNCTION(BlueprintCallable, Category = Attack)
 	UAttackCollider* GetCollider(EBodyParts eBodyPart);
 
 	UFUNCTION(BlueprintCallable, Category = Attack)
 	void SetCollider(EBodyParts eBodyPart, UAttackCollider* pkCollider);
 
+	// sweep a body part for hits while it is active, replacing collider overlaps - a new swing can hit the same targets again
+	UFUNCTION(BlueprintCallable, Category = Attack)
+	void SetAttackSweepActive(EBodyParts eBodyPart, bool bActive, float fRadius = 20.0f);
+
+	// stop sweeping every body part
+	void EndAttackSweeps();
+
+	// a body part sweep hit a character on another team, the frame after the sweep
+	UFUNCTION(BlueprintImplementableEvent, Category = Attack)
+	void OnSweptHit(AHackNSlacksCharacter* pkVictim, EBodyParts eBodyPart, const FHitResult& oHit);
+
 	UFUNCTION(BlueprintCallable, Category = Buff)
 	FBuff& AddBuffDefault(TSubclassOf<UBuffDef> pkBuffDef);
 
@@ -61,6 +129,55 @@ public:
 
 	void RemoveNearbyChest(AChest* pkChest);
 
+	// run the next init stage, called by the spawn init queue - returns true once the character is active
+	bool RunInitStage();
+
+	// all init stages have run
+	UFUNCTION(BlueprintCallable, Category = Character)
+	bool IsInitialized() const { return eInitStage == ESpawnInitStage::Done; }
+
+	// start the ragdoll, called by the death queue - returns false if the character was healed while queued
+	bool FinishDeath();
+
+	// died, whether or not the death queue has reached the character yet
+	UFUNCTION(BlueprintCallable, Category = Character)
+	bool IsDying() const { return eDeathStage != EDeathStage::Alive; }
+
+	// take the character back out of the death queue, stopping its ragdoll if it has started - e.g. when a checkpoint is restored
+	// health is left to the caller
+	void Revive();
+
+	// merge body part and gear meshes into the character's mesh - call after gear changes, the merge happens over the next frames
+	UFUNCTION(BlueprintCallable, Category = Gear)
+	void RequestMeshMerge();
+
+	// merge now, called by the mesh merge queue - returns false without merging while an attack or charge is playing, a new
+	// mesh would restart the montage
+	bool UpdateMergedMesh();
+
+	// gear and body parts live on every character, enemies merge their meshes too
+	UPROPERTY(EditAnywhere, Category = "Gear")
+	AGear* apkEquippedGear[(int32)EEquipSlots::Count];
+
+	UPROPERTY(EditAnywhere, Category = "Mesh")
+	USkeletalMeshComponent* apkBodyMeshes[(int32)EBodyParts::Count];
+
+	// the character's own mesh before body parts and gear were merged into it
+	UPROPERTY()
+	USkeletalMesh* pkBaseMesh;
+
+	// body part and gear mesh components hidden because they are part of the merged mesh
+	UPROPERTY()
+	TArray<USkinnedMeshComponent*> apkMergedComponents;
+
+	// store a picked up item as an inventory record and destroy its actor - returns false if there is no inventory or item
+	UFUNCTION(BlueprintCallable, Category = Item)
+	bool AddToInventory(AItem* pkItem);
+
+	// spawn an item actor from an inventory record in front of the character
+	UFUNCTION(BlueprintCallable, Category = Item)
+	AItem* DropFromInventory(int32 iRecord);
+
 	virtual bool SetWeapon(AWeapon* pkWeap);
 
 	UFUNCTION(BlueprintCallable, Category = Character)
@@ -80,9 +197,19 @@ public:
 
 	void AddSimulatingBody(const FName& sBoneName, float fDuration);
 
+	// log object size and allocated bytes per character class, to check memory with many characters alive
+	static void ReportFootprint();
+
+	// log how often frames ran out of combat steps and the combat time dropped since the last report
+	static void ReportCombatSteps();
+
 	UFUNCTION(BlueprintCallable, Category = AI)
 	void ResetCurrentAttackRef();
 
+	// attacks by other teams started near the character since the last call - AI reacts to these in one batch instead of polling attackers
+	UFUNCTION(BlueprintCallable, Category = AI)
+	int32 ReadAttackEvents(float fRadius, TArray<FAttackEvent>& aoEvents);
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = AI)
 	int32 iCurrentAttack;
 
@@ -103,37 +230,44 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Character)
 	FWeaponSpawnStruct oSpawnWithWeapon;
 
+	// seconds a corpse ragdolls before the death queue destroys it, zero or less keeps it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Character)
+	float fCorpseLifetime;
+
 	// which team the character belongs to, player, enemy, environment
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Game)
 	ETeams eTeam;
 
-	// Camera Variables
+protected:
+	// combat and movement state touched every tick
+	FCharacterHotState oHot;
 
-	//FollowCam
-	/* Float that changes when the camera starts to rotate to follow the players facing direction */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CameraAdjustments)
-	float fAngleInfluence;
+	ESpawnInitStage eInitStage;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CameraAdjustments)
-	float fCameraRotRate;
+	EDeathStage eDeathStage;
 
-	//LockCam
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = CameraAdjustments)
-	AActor* aClosestActorInView;
+	// collision the ragdoll replaced, put back by StopDeathRagdoll
+	FName sMeshProfileBeforeRagdoll;
+	TEnumAsByte<ECollisionEnabled::Type> eCapsuleCollisionBeforeRagdoll;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lock-On")
-	bool bIsLockedOn;
+	// actor was hidden before init hid it
+	bool bHiddenBeforeInit;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lock-On")
-	bool bDisableAutoCameraFollow;
+	// actor collided before init turned collision off
+	bool bCollisionBeforeInit;
 
-	UPROPERTY(EditAnywhere, Category = "Gear")
-	AGear* apkEquippedGear[(int32)EEquipSlots::Count];
+	// record for an attack that is missing from the cooked attack data or out of date there
+	FAttackRecord oUncookedRecord;
 
-	UPROPERTY(EditAnywhere, Category = "Mesh")
-	USkeletalMeshComponent* apkBodyMeshes[(int32)EBodyParts::Count];
+	// attacks started, to tell whether an attack input was accepted - replays do not count theirs
+	uint32 iAttacksStarted;
 
-protected:
+	// CancelAttack was asked for at iAttacksStarted, the attack is reset on the next combat step
+	bool bPendingAttackCancel;
+	uint32 iAttacksAtCancel;
+
+	// set the current attack and its record - the only place poCurrentAttack should change
+	void SetCurrentAttack(FAttackEntry* poAttack);
 
 	/** Called for forwards/backward input */
 	void MoveForward(float Value);
@@ -157,15 +291,50 @@ protected:
 
 	virtual void UpdateBuffs();
 
+	// health reached zero - the death queue handles the rest on a later frame
 	void OnDeath();
 
+	// stop buffs so they do not keep ticking on a dead character
+	void StopBuffs();
+
+	// simulate the mesh instead of the capsule, started by the death queue
+	virtual void StartDeathRagdoll();
+
+	// put the mesh back on the capsule and let the capsule collide and move again
+	virtual void StopDeathRagdoll();
+
+	// dying characters go through the death queue, otherwise buffs are stopped when health reaches zero and nothing else happens
+	virtual bool UsesDeathQueue() const;
+
 	UFUNCTION()
 	void OnDestroy();
 
+	virtual void PostInitializeComponents() override;
+
 	virtual void BeginPlay() override;
 
+	// spread setup over several frames through the spawn init queue, otherwise run every stage in BeginPlay
+	virtual bool ShouldTimeSliceInit() const;
+
+	// the last init stage has run and the character has started ticking - setup that needs the anim instance, colliders or weapon goes here
+	virtual void OnInitialized();
+
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
+
 	virtual void TickActor(float DeltaTime, enum ELevelTick TickType, FActorTickFunction& ThisTickFunction) override;
 
+	// advance combo, charge and dodge timers
+	virtual void TickCombat(float DeltaTime);
+
+	// cancel the current attack on the next combat step - an attack started before then is kept
+	void CancelAttack();
+
+	// run as many fixed combat steps as the frame's time covers, returns the number run
+	int32 StepCombat(float DeltaTime);
+
+	// after each fixed combat step, not when predicted steps are replayed
+	virtual void OnCombatStep(float fStepTime);
+
 	virtual void Jump();
 
 	virtual void Falling() override;
@@ -204,6 +373,9 @@ protected:
 
 	void GetClosestItem();
 
+	// deferred task for GetClosestItem
+	void UpdateClosestItem(float fElapsed);
+
 	AChest* GetClosestOpenableChest();
 
 	// ATTACK
@@ -219,22 +391,15 @@ public:
 	AWeapon* pkWeapon;
 
 protected:
-	// if the character is charging an attack
-	bool bCharging;
-
-	// charge attack timer
-	float fChargeTimer;
+	// next attack event to read from the world's attack event buffer
+	uint64 iAttackEventCursor;
 
-	// combo input timer
-	UPROPERTY(BlueprintReadWrite, Category = Attack)
-	float fComboTimer;
+	// let nearby AI know an attack has started
+	void PublishAttackEvent(FAttackEntry* poAttackEntry);
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attack)
 	float fAttackTurnRate;
 
-	// current attack the character is performing
-	FAttackEntry* poCurrentAttack;
-
 	// UNUSED - using weapons references
 
 	// character's reference to their attack dictionary
@@ -251,34 +416,28 @@ protected:
 	UPROPERTY(EditAnywhere, Category = Attack)
 	FBodySocket apoSockets[(int32)EBodyParts::Count];
 
-	//
+	// bone each socket is attached to on the current mesh, INDEX_NONE if the socket is not set
+	int32 aiSocketBones[(int32)EBodyParts::Count];
 
-	// the character is on the ground
-	bool bOnGround;
+	// socket world transforms for the current frame, read by colliders, effects and indicators instead of the mesh
+	FTransform aoSocketTransforms[(int32)EBodyParts::Count];
 
-	// the character is sprinting
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Player)
-	bool bSprinting;
+	FSocketTransformTickFunction oSocketTick;
 
-	// DODGE
+	// attack hit system swing for each body part, zero while not sweeping
+	int32 aiAttackSwings[(int32)EBodyParts::Count];
 
-	// the character is dodging
-	UPROPERTY(BlueprintReadOnly, Category = Dodge)
-	bool bDodging;
-	
-	// direction the character is dodging
-	FVector oDodgeDir;
+	// look up socket bones again after the mesh changes
+	void CacheSocketBones();
 
-	// how many times the character has dodged recently
-	int32 iDodgeCount;
+	//
+
+	// DODGE
 
 	// maximum number of times the character can dodge before they have to wait for the dodge lock to finish
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Dodge)
 	int32 iMaxDodgeCount;
 
-	// how long the character has been unable to move after dodging
-	float fDodgeLockTimer;
-
 	// how long the character will be unable to move after dodging
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Dodge)
 	float fDodgeLockDuration;
@@ -300,26 +459,21 @@ protected:
 	// movement during an attack
 	FVector oAttackVelocity;
 
-	// list of items the character is close enough to pick up
-	TDoubleLinkedList<AItem*> apkNearbyItems;
-	
-	TDoubleLinkedList<AChest*> apkNearbyChests;
-
 	// the physics bodies of the character that have been hit recently
-	TDoubleLinkedList<FSimulatingBody> aoSimulatingBodies;
+	TTrackedList<FSimulatingBody, ECombatMemTag::SimulatingBodies> aoSimulatingBodies;
 
 	UPROPERTY(BlueprintReadWrite, Category = Buff)
 	TArray<FBuff> aoBuffs;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Item)
-	TArray<AItem*> apkInventory;
-
-	// the closest item to the character
-	AItem* pkClosestItem;
+	TTrackedSize<ECombatMemTag::Buffs> oBuffsMemory;
 
 	UCharacterAnimInstance* pkCharAnim;
 
-	// Camera Functions
+	// optional components, found when components are initialized
+
+	UPROPERTY()
+	UCameraFollowComponent* pkCameraFollow;
 
-	void CameraFollow(float DeltaTime);
+	UPROPERTY()
+	UCharacterInventoryComponent* pkInventory;
 };
\ No newline at end of file
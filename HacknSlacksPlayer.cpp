@@ -10,6 +10,16 @@
 #include "CharacterAnimInstance.h"
 #include "HackNSlacksGameMode.h"
 #include "HNSGameInstance.h"
+#include "HNSNames.h"
+#include "StreamingPredictorComponent.h"
+#include "CameraFollowComponent.h"
+#include "CharacterInventoryComponent.h"
+#include "UIEventBus.h"
+#include "DeferredTaskScheduler.h"
+#include "AngleMath.h"
+#include "PlayerRegistry.h"
+#include "TargetingSnapshot.h"
+#include "AttackVelocityTrack.h"
 #include "Runtime/Engine/Classes/Kismet/KismetMaterialLibrary.h"
 #include "HacknSlacksPlayer.h"
 
@@ -17,6 +27,8 @@ AHacknSlacksPlayer::AHacknSlacksPlayer(const FObjectInitializer& ObjectInitializ
 {
 	eTeam = ETeams::Player;
 
+	iPlayerSlot = INDEX_NONE;
+
 	// Create a camera boom (pulls in towards the player if there is a collision)
 	CameraBoom = ObjectInitializer.CreateDefaultSubobject<USpringArmComponent>(this, TEXT("CameraBoom"));
 	CameraBoom->AttachTo(RootComponent);
@@ -28,13 +40,25 @@ AHacknSlacksPlayer::AHacknSlacksPlayer(const FObjectInitializer& ObjectInitializ
 	FollowCamera->AttachTo(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
-	socketFront = new FName("skt_ParticleFront");
-	socketUpper = new FName("skt_ParticleUpper");
-	socketLower = new FName("skt_ParticleLower");
+	// Predictive level streaming driven by the player's movement
+	StreamingPredictor = ObjectInitializer.CreateDefaultSubobject<UStreamingPredictorComponent>(this, TEXT("StreamingPredictor"));
+
+	// Player only state that enemies do not carry
+	pkCameraFollow = ObjectInitializer.CreateDefaultSubobject<UCameraFollowComponent>(this, TEXT("CameraFollow"));
+	pkInventory = ObjectInitializer.CreateDefaultSubobject<UCharacterInventoryComponent>(this, TEXT("Inventory"));
 
 	for (int32 iSheath = 0; iSheath < (int32)ESheaths::Count; iSheath++)
 		aoSheaths[iSheath].eSheath = (ESheaths)iSheath;
 
+	bPendingStopJumping = false;
+	bPerBuffEvents = false;
+
+	fInputBufferTime = 0.2f;
+
+	iLastInputFrame = INDEX_NONE;
+	fInputTimeSince = 0.0f;
+	bInputSinceAck = false;
+
 	oLastCheckpoint = FTransform((FVector)NAN);
 }
 
@@ -47,91 +71,217 @@ void AHacknSlacksPlayer::BeginPlay()
 	if (pkSoftLockSphere)
 	{
 		TScriptDelegate<> kBeginOverlap;
-		kBeginOverlap.BindUFunction(this, "SoftLockSphereBeginOverlap");
+		kBeginOverlap.BindUFunction(this, FHNSNames::SoftLockSphereBeginOverlap);
 
 		pkSoftLockSphere->OnComponentBeginOverlap.Add(kBeginOverlap);
 
 		TScriptDelegate<> kEndOverlap;
-		kEndOverlap.BindUFunction(this, "SoftLockSphereEndOverlap");
+		kEndOverlap.BindUFunction(this, FHNSNames::SoftLockSphereEndOverlap);
 
 		pkSoftLockSphere->OnComponentEndOverlap.Add(kEndOverlap);
 	}
 
 	iLives = 3;
 
-	UHNSGameInstance::pkPlayer = this;
+	// presentation work that can lag a frame or two behind the simulation
+	FDeferredTaskScheduler& oScheduler = FDeferredTaskScheduler::Get();
+
+	oScheduler.Register(this, FDeferredTask::CreateUObject(this, &AHacknSlacksPlayer::UpdateLookRotation), 2, 1.0f / 30.0f);
+	oScheduler.Register(this, FDeferredTask::CreateUObject(this, &AHacknSlacksPlayer::UpdateSoftLockArrow), 1, 1.0f / 30.0f);
 
 	// TEST
 	//AddBuff(UBuffDef::StaticClass(), 1.0f, 10.0f, 1.0f);
 }
 
-void AHacknSlacksPlayer::TickActor(float DeltaTime, enum ELevelTick TickType, FActorTickFunction& ThisTickFunction)
+void AHacknSlacksPlayer::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::TickActor(DeltaTime, TickType, ThisTickFunction);
+	UnregisterPlayerSlot();
 
-	// reset soft lock target is the target is being destroyed
-	if (pkSoftLockedTarget && pkSoftLockedTarget->IsPendingKill())
-		pkSoftLockedTarget = nullptr;
+	Super::EndPlay(EndPlayReason);
+}
 
-	if (UCharacterMovementComponent* pkCharMovement = GetCharacterMovement())
+// server side possession, covers the listen server's own players
+void AHacknSlacksPlayer::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	RegisterPlayerSlot();
+}
+
+// the owning client learns it possesses the pawn here
+void AHacknSlacksPlayer::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	RegisterPlayerSlot();
+}
+
+void AHacknSlacksPlayer::UnPossessed()
+{
+	UnregisterPlayerSlot();
+
+	Super::UnPossessed();
+}
+
+void AHacknSlacksPlayer::RegisterPlayerSlot()
+{
+	APlayerController* pkController = GetPlayerController();
+	ULocalPlayer* pkLocalPlayer = pkController ? Cast<ULocalPlayer>(pkController->Player) : nullptr;
+
+	if (!pkLocalPlayer || !IsLocallyControlled())
+		return;
+
+	FPlayerRegistry* poPlayers = FPlayerRegistry::Get(GetWorld());
+
+	if (!poPlayers)
+		return;
+
+	iPlayerSlot = poPlayers->Register(this, pkLocalPlayer->GetControllerId());
+
+	// first player, for code that still expects a single player
+	if (iPlayerSlot == 0)
+		UHNSGameInstance::pkPlayer = this;
+}
+
+void AHacknSlacksPlayer::UnregisterPlayerSlot()
+{
+	if (FPlayerRegistry* poPlayers = FPlayerRegistry::Get(GetWorld()))
+		poPlayers->Unregister(this);
+
+	if (UHNSGameInstance::pkPlayer == this)
+		UHNSGameInstance::pkPlayer = nullptr;
+
+	iPlayerSlot = INDEX_NONE;
+}
+
+AHacknSlacksPlayer* AHacknSlacksPlayer::GetPlayerInSlot(UObject* pkWorldContext, int32 iSlot)
+{
+	UWorld* pkWorld = GEngine->GetWorldFromContextObject(pkWorldContext);
+
+	FPlayerRegistry* poPlayers = FPlayerRegistry::Get(pkWorld);
+
+	return poPlayers ? poPlayers->GetPlayer(iSlot) : nullptr;
+}
+
+void AHacknSlacksPlayer::UpdateSoftLockArrow(float fElapsed)
+{
+	if (!pkSoftLockArrow)
+		return;
+
+	if (pkSoftLockedTarget && !pkSoftLockedTarget->IsPendingKill())
 	{
-		// set velocity to dodging speed
-		if (bDodging)
-			pkCharMovement->Velocity = FVector(oDodgeDir.X * fDodgeSpeed, oDodgeDir.Y * fDodgeSpeed, pkCharMovement->Velocity.Z);
+		// set arrows position to above the soft lock target
+		pkSoftLockArrow->SetWorldLocation(pkSoftLockedTarget->GetTopSocketLocation() + FVector(0.0f, 0.0f, pkSoftLockedTarget->GetSimpleCollisionHalfHeight()));
+		pkSoftLockArrow->SetHiddenInGame(false);
+	}
+	else
+		pkSoftLockArrow->SetHiddenInGame(true);
+}
 
-		// scale deceleration based on movement speed
-		pkCharMovement->BrakingDecelerationWalking = FMath::Lerp(fMinDeceleration, fMaxDeceleration, FMath::Min(1.0f, pkCharMovement->Velocity.Size() / fSprintSpeed));
+void AHacknSlacksPlayer::UpdateLookRotation(float fElapsed)
+{
+	if (pkCharAnim)
+	{
+		// dunno if this check could still cause a crash - maybe store references instead?
+		if (pkClosestAngleTarget != nullptr && pkClosestAngleTarget->IsValidLowLevel())
+			pkCharAnim->oLookRot = (pkClosestAngleTarget->GetActorLocation() - GetActorLocation()).Rotation();
+		else
+			pkCharAnim->oLookRot = FollowCamera->GetComponentRotation();
 	}
+}
 
-	if (bOnGround)
+void AHacknSlacksPlayer::OnCombatStep(float fStepTime)
+{
+	if (oHot.bOnGround)
 	{
 		// save ground position
 		oLastGroundPosition = GetActorLocation();
 		fAirTimer = 0.0f;
 	}
-	else if ((fAirTimer += DeltaTime) >= fMaxAirTime)
+	else if ((fAirTimer += fStepTime) >= fMaxAirTime)
 	{
 		// reset to last saved ground position
 		SetActorLocation(oLastGroundPosition);
 		fAirTimer = 0.0f;
 	}
 
+	// close the predicted step now that it has run
+	if (poPrediction.IsValid() && Role < ROLE_Authority && IsLocallyControlled())
+		poPrediction->EndFrame(fStepTime, this);
+
+	if (Role == ROLE_Authority && iLastInputFrame != INDEX_NONE && !IsLocallyControlled())
+		fInputTimeSince += fStepTime;
+}
+
+bool AHacknSlacksPlayer::ShouldTimeSliceInit() const
+{
+	return false;
+}
+
+bool AHacknSlacksPlayer::UsesDeathQueue() const
+{
+	return false;
+}
+
+void AHacknSlacksPlayer::TickActor(float DeltaTime, enum ELevelTick TickType, FActorTickFunction& ThisTickFunction)
+{
+	if (bPendingStopJumping)
+	{
+		bPendingStopJumping = false;
+		StopJumping();
+	}
+
+	// presses read since the last tick
+	FireBufferedInputs();
+
+	Super::TickActor(DeltaTime, TickType, ThisTickFunction);
+
+	// presses the combat tick just made legal, such as an attack queued behind one that ended
+	FireBufferedInputs();
+
+	// reset soft lock target is the target is being destroyed
+	if (pkSoftLockedTarget && pkSoftLockedTarget->IsPendingKill())
+		pkSoftLockedTarget = nullptr;
+
+	if (UCharacterMovementComponent* pkCharMovement = GetCharacterMovement())
+	{
+		// set velocity to dodging speed
+		if (oHot.bDodging)
+			pkCharMovement->Velocity = FVector(oHot.oDodgeDir.X * fDodgeSpeed, oHot.oDodgeDir.Y * fDodgeSpeed, pkCharMovement->Velocity.Z);
+
+		// scale deceleration based on movement speed
+		pkCharMovement->BrakingDecelerationWalking = FMath::Lerp(fMinDeceleration, fMaxDeceleration, FMath::Min(1.0f, pkCharMovement->Velocity.Size() / fSprintSpeed));
+	}
+
 	if (InputComponent)
 	{
-		FVector oInputDir = FVector(InputComponent->GetAxisValue("MoveForward"), InputComponent->GetAxisValue("MoveRight"), 0.0f);
+		FVector oInputDir = FVector(InputComponent->GetAxisValue(FHNSNames::MoveForward), InputComponent->GetAxisValue(FHNSNames::MoveRight), 0.0f);
 
 		FVector oTargetDir = oInputDir.IsZero() ? FollowCamera->GetForwardVector() : FRotator(0.0f, FollowCamera->GetComponentRotation().Yaw, 0.0f).RotateVector(oInputDir.GetSafeNormal());
 
 		// only get a new target each tick if the player is not attacking
-		//if (!poCurrentAttack)
+		//if (!oHot.poCurrentAttack)
 			GetAttackAngle(oTargetDir);
 
-		if (pkSoftLockArrow)
-		{
-			if (pkSoftLockedTarget)
-			{
-				// set arrows position to above the soft lock target
-				pkSoftLockArrow->SetWorldLocation(pkSoftLockedTarget->GetActorLocation() + FVector(0.0f, 0.0f, pkSoftLockedTarget->GetSimpleCollisionHalfHeight() * 2));
-				pkSoftLockArrow->SetHiddenInGame(false);
-			}
-			else
-				pkSoftLockArrow->SetHiddenInGame(true);
-		}
 	}
 
 	if (iComboHitCount > 0 && (fComboNoHitTimer += DeltaTime) >= fComboNoHitDuration)
 		ResetComboCounter();
 
-	if (pkCharAnim)
-	{
-		// dunno if this check could still cause a crash - maybe store references instead?
-		if (pkClosestAngleTarget != nullptr && pkClosestAngleTarget->IsValidLowLevel())
-			pkCharAnim->oLookRot = (pkClosestAngleTarget->GetActorLocation() - GetActorLocation()).Rotation();
-		else
-			pkCharAnim->oLookRot = FollowCamera->GetComponentRotation();
-	}
-
+	// camera interpolation, stepping it less often than every frame makes it judder
 	PitchAutoAdjustment(DeltaTime);
+
+	// tell the owning client where its predicted inputs actually led, once a step has run since them
+	if (Role == ROLE_Authority && iLastInputFrame != INDEX_NONE && !IsLocallyControlled() && fInputTimeSince > 0.0f)
+		SendPredictionAck();
+
+	// one widget update for everything that happened this frame
+	if (oUIEvents.HasPending())
+		oUIEvents.Flush(this);
+
+	// server streams combat state to the client that owns this player
+	if (Role == ROLE_Authority && GetNetMode() != NM_Standalone && !IsLocallyControlled())
+		SendCombatState();
 }
 
 void AHacknSlacksPlayer::ReceiveAnyDamage(float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser)
@@ -162,6 +312,35 @@ float AHacknSlacksPlayer::ModHealth(float fMod)
 	return fHealth;
 }
 
+void AHacknSlacksPlayer::SetCheckpoint(const FTransform& oCheckpoint)
+{
+	oLastCheckpoint = oCheckpoint;
+
+	oCheckpointSnapshot.Capture(this);
+
+	// keep a copy on disk to resume from after a crash
+	oCheckpointSnapshot.SaveToFile(FCheckpointSnapshot::GetDefaultPath());
+}
+
+bool AHacknSlacksPlayer::RespawnAtCheckpoint()
+{
+	return oCheckpointSnapshot.Restore(this, false);
+}
+
+bool AHacknSlacksPlayer::ResumeFromSavedCheckpoint()
+{
+	if (!oCheckpointSnapshot.LoadFromFile(FCheckpointSnapshot::GetDefaultPath()))
+		return false;
+
+	// lives are part of the saved state when resuming a session
+	if (!oCheckpointSnapshot.Restore(this, true))
+		return false;
+
+	oLastCheckpoint = GetActorTransform();
+
+	return true;
+}
+
 void AHacknSlacksPlayer::SetTokens(int32 iNewTokens)
 {
 	iTokens = FMath::Max(iNewTokens, 0);
@@ -187,11 +366,11 @@ void AHacknSlacksPlayer::SetTokens(int32 iNewTokens)
 // set if the player is dodging, set ground friction
 void AHacknSlacksPlayer::SetDodging(bool bIsDodging)
 {
-	if (bDodging != bIsDodging)
+	if (oHot.bDodging != bIsDodging)
 	{
 		UCharacterMovementComponent* pkCharMovement = GetCharacterMovement();
 
-		if (bDodging)
+		if (oHot.bDodging)
 			pkCharMovement->GroundFriction = fSavedFriction;
 		else
 		{
@@ -207,7 +386,7 @@ void AHacknSlacksPlayer::SetDodging(bool bIsDodging)
 void AHacknSlacksPlayer::SoftLockSphereBeginOverlap(class AActor* pkOther, class UPrimitiveComponent* pkOtherComp, int32 iOtherBodyIndex, bool bFromSweep, const FHitResult &oSweepResult)
 {
 	if (AEnemy* pkEnemy = Cast<AEnemy>(pkOther))
-		if (pkEnemy->fHealth > 0.0f && !apkNearbyEnemies.FindNode(pkEnemy))
+		if (pkEnemy->fHealth > 0.0f && !pkEnemy->IsDying() && !apkNearbyEnemies.FindNode(pkEnemy))
 			apkNearbyEnemies.AddTail(pkEnemy);
 }
 
@@ -218,17 +397,23 @@ void AHacknSlacksPlayer::SoftLockSphereEndOverlap(class AActor* pkOther, class U
 		apkNearbyEnemies.RemoveNode(pkEnemy);
 }
 
-/*FBuff& AHacknSlacksPlayer::AddBuff(TSubclassOf<UBuffDef> pkBuffDef, float fIntensity, float fDuration, int32 iTickCount)
+FBuff& AHacknSlacksPlayer::AddBuff(TSubclassOf<UBuffDef> pkBuffDef, float fIntensity, float fDuration, int32 iTickCount)
 {
 	FBuff& oBuff = Super::AddBuff(pkBuffDef, fIntensity, fDuration, iTickCount);
 
+	// new buffs take the slot at the end of the bar, the widget is told once at the end of the frame
 	if (oBuff.iIndex == -1)
+	{
+		oUIEvents.BuffSlotAdded(iActiveBuffs);
 		oBuff.iIndex = iActiveBuffs++;
+	}
 
-	OnAddBuff(oBuff);
+	// opt in for blueprints that still listen for single buffs
+	if (bPerBuffEvents)
+		OnAddBuff(oBuff);
 
 	return oBuff;
-}*/
+}
 
 // do any other logic for hits here, lifesteal, etc
 void AHacknSlacksPlayer::AddComboHit(float fDamage)
@@ -239,59 +424,55 @@ void AHacknSlacksPlayer::AddComboHit(float fDamage)
 	// increase combo counter
 	iComboHitCount++;
 
-	// call blueprint event
-	OnComboCountIncreased(iComboHitCount);
+	// blueprint event is sent once per frame with the final count
+	oUIEvents.ComboCountIncreased(iComboHitCount);
 }
 
 void AHacknSlacksPlayer::ResetComboCounter()
 {
-	// call blueprint event
-	OnComboCountReset(iComboHitCount);
+	oUIEvents.ComboCountReset(iComboHitCount);
 
 	fComboNoHitTimer = 0.0f;
 	iComboHitCount = 0;
 }
 
 // change weapon - does not set any animation
-/*bool AHacknSlacksPlayer::SetWeapon(AWeapon* pkNewWeapon)
+// weapons stay attached to both the hand and their sheath, swapping only changes which one is visible
+bool AHacknSlacksPlayer::SetWeapon(AWeapon* pkNewWeapon)
 {
 	// same weapon
 	if (pkWeapon == pkNewWeapon)
 		return true;
 
-	ResetCombo();
+	// cancel the attack on the next combat step instead of tearing down the combo mid-swap, an attack started after the swap is kept
+	CancelAttack();
 
-	// unequip current weapon
-	if (pkWeapon)
-	{
-		FSheath& oSheath = aoSheaths[(int32)pkWeapon->eSheath];
+	// weapon was never placed in a sheath, set it up once
+	if (pkNewWeapon && aoSheathMeshes[(int32)pkNewWeapon->eSheath].pkWeapon != pkNewWeapon)
+		RegisterSheathWeapon(pkNewWeapon);
 
-		oSheath.pkWeapon = pkWeapon;
-		pkWeapon->Unequip(GetMesh(), oSheath.sSocketName);
-	}
+	// sheath current weapon
+	if (pkWeapon)
+		ShowWeaponInHand(pkWeapon, false);
 
 	// equip weapon
 	pkWeapon = pkNewWeapon;
 
 	if (pkWeapon)
 	{
-		FSheath& oSheath = aoSheaths[(int32)pkWeapon->eSheath];
-
-		// need to check in case the previous weapon was placed in this sheath
-		if (pkWeapon == oSheath.pkWeapon)
-			oSheath.pkWeapon = nullptr;
-
-		pkWeapon->Equip();
+		FCombatNetDictionaries::Get().RegisterAttacks(pkWeapon->GetAttackDictionary());
+		FAttackVelocityTrack::BakeDictionary(pkWeapon->GetAttackDictionary());
+		ShowWeaponInHand(pkWeapon, true);
 	}
 
 	return true;
-}*/
+}
 
 // enum version to swap with sheathed weapon
-/*bool AHacknSlacksPlayer::SetWeapon(ESheaths eSheath)
+bool AHacknSlacksPlayer::SetWeapon(ESheaths eSheath)
 {
 	return SetWeapon(aoSheaths[(int32)eSheath].pkWeapon);
-}*/
+}
 
 // choose animation for changing weapon
 /*void AHacknSlacksPlayer::AnimSetWeapon(ESheaths eNewSheath)
@@ -309,9 +490,46 @@ void AHacknSlacksPlayer::ResetComboCounter()
 }*/
 
 // called from the armory to apply weapons to slacks
-/*void AHacknSlacksPlayer::AssignWeapon(AWeapon* pkSheathWeapon)
+void AHacknSlacksPlayer::AssignWeapon(AWeapon* pkSheathWeapon)
+{
+	if (!pkSheathWeapon)
+		return;
+
+	RegisterSheathWeapon(pkSheathWeapon);
+
+	// equip weapon
+	if (!pkWeapon)
+		SetWeapon(pkSheathWeapon);
+	// sheath weapon
+	else if (pkWeapon != pkSheathWeapon)
+		ShowWeaponInHand(pkSheathWeapon, false);
+}
+
+// attach the weapon to the hand and copy its meshes onto the sheath socket - render state and physics are only changed here
+void AHacknSlacksPlayer::RegisterSheathWeapon(AWeapon* pkSheathWeapon)
 {
 	FSheath& oSheath = aoSheaths[(int32)pkSheathWeapon->eSheath];
+	FSheathMeshes& oSheathMeshes = aoSheathMeshes[(int32)pkSheathWeapon->eSheath];
+
+	if (oSheathMeshes.pkWeapon == pkSheathWeapon)
+		return;
+
+	// a different weapon was in this sheath, let it go
+	if (AWeapon* pkOldWeapon = oSheathMeshes.pkWeapon)
+	{
+		if (pkOldWeapon == pkWeapon)
+			pkWeapon = nullptr;
+
+		pkOldWeapon->SetActorHiddenInGame(false);
+		pkOldWeapon->SetActorEnableCollision(true);
+		pkOldWeapon->Drop();
+	}
+
+	for (UStaticMeshComponent* pkSheathMesh : oSheathMeshes.apkMeshes)
+		if (pkSheathMesh)
+			pkSheathMesh->DestroyComponent();
+
+	oSheathMeshes.apkMeshes.Reset();
 
 	pkSheathWeapon->pkOwner = this;
 	pkSheathWeapon->oMainWeapon.pkCollider->pkOwner = this;
@@ -320,21 +538,49 @@ void AHacknSlacksPlayer::ResetComboCounter()
 	// weapon should render behind objects
 	pkSheathWeapon->oMainWeapon.SetRenderCustomDepth(true);
 	pkSheathWeapon->oOffWeapon.SetRenderCustomDepth(true);
-	
+
 	pkSheathWeapon->pkMesh->SetSimulatePhysics(false);
-	
+
 	pkSheathWeapon->SetOnGround(false);
 
-	// equip weapon
-	if (!pkWeapon)
-		SetWeapon(pkSheathWeapon);
-	// sheath weapon
-	else
+	// weapon stays attached to the hand while it is assigned
+	pkSheathWeapon->Equip();
+
+	// copy every weapon mesh onto the sheath socket
+	TArray<UStaticMeshComponent*> apkWeaponMeshes;
+	pkSheathWeapon->GetComponents<UStaticMeshComponent>(apkWeaponMeshes);
+
+	for (UStaticMeshComponent* pkWeaponMesh : apkWeaponMeshes)
 	{
-		oSheath.pkWeapon = pkSheathWeapon;
-		pkSheathWeapon->pkMesh->AttachTo(GetMesh(), oSheath.sSocketName, EAttachLocation::SnapToTarget, false);
+		UStaticMeshComponent* pkSheathMesh = NewObject<UStaticMeshComponent>(this);
+
+		pkSheathMesh->SetStaticMesh(pkWeaponMesh->StaticMesh);
+		pkSheathMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		pkSheathMesh->SetRenderCustomDepth(true);
+		pkSheathMesh->SetVisibility(false);
+		pkSheathMesh->AttachTo(GetMesh(), oSheath.sSocketName, EAttachLocation::SnapToTarget, false);
+		pkSheathMesh->SetRelativeTransform(pkWeaponMesh->GetComponentTransform().GetRelativeTransform(pkSheathWeapon->GetActorTransform()));
+		pkSheathMesh->RegisterComponent();
+
+		oSheathMeshes.apkMeshes.Add(pkSheathMesh);
 	}
-}*/
+
+	oSheathMeshes.pkWeapon = pkSheathWeapon;
+	oSheath.pkWeapon = pkSheathWeapon;
+}
+
+void AHacknSlacksPlayer::ShowWeaponInHand(AWeapon* pkSheathWeapon, bool bInHand)
+{
+	pkSheathWeapon->SetActorHiddenInGame(!bInHand);
+	pkSheathWeapon->SetActorEnableCollision(bInHand);
+
+	FSheathMeshes& oSheathMeshes = aoSheathMeshes[(int32)pkSheathWeapon->eSheath];
+
+	if (oSheathMeshes.pkWeapon == pkSheathWeapon)
+		for (UStaticMeshComponent* pkSheathMesh : oSheathMeshes.apkMeshes)
+			if (pkSheathMesh)
+				pkSheathMesh->SetVisibility(!bInHand);
+}
 
 //////////////////////////////////////////////////////////////////////////
 // Input
@@ -345,88 +591,63 @@ void AHacknSlacksPlayer::SetupPlayerInputComponent(class UInputComponent* InputC
 
 	// Set up gameplay key bindings
 	check(InputComponent);
-	InputComponent->BindAction("Jump", IE_Pressed, this, &AHacknSlacksPlayer::Jump);
-	InputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
+	InputComponent->BindAction(FHNSNames::Jump, IE_Released, this, &AHacknSlacksPlayer::OnEndJump);
 
-	InputComponent->BindAxis("MoveForward", this, &AHacknSlacksPlayer::MoveForward);
-	InputComponent->BindAxis("MoveRight", this, &AHacknSlacksPlayer::Strafe);
+	InputComponent->BindAxis(FHNSNames::MoveForward, this, &AHacknSlacksPlayer::MoveForward);
+	InputComponent->BindAxis(FHNSNames::MoveRight, this, &AHacknSlacksPlayer::Strafe);
 
 	// We have 2 versions of the rotation bindings to handle different kinds of devices differently
 	// "turn" handles devices that provide an absolute delta, such as a mouse.
 	// "turnrate" is for devices that we choose to treat as a rate of change, such as an analog joystick
-	InputComponent->BindAxis("Turn", this, &APawn::AddControllerYawInput);
-	InputComponent->BindAxis("TurnRate", this, &AHacknSlacksPlayer::TurnAtRate);
-	InputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
-	InputComponent->BindAxis("LookUpRate", this, &AHacknSlacksPlayer::LookUpAtRate);
-
-	InputComponent->BindAction("LightAttack", IE_Pressed, this, &AHacknSlacksPlayer::OnLightAttack);
-	InputComponent->BindAction("HeavyAttack", IE_Pressed, this, &AHacknSlacksPlayer::OnHeavyAttack);
-	InputComponent->BindAction("LightAttack", IE_Released, this, &AHacknSlacksPlayer::EndCharge);
-	InputComponent->BindAction("HeavyAttack", IE_Released, this, &AHacknSlacksPlayer::EndCharge);
-	//InputComponent->BindAction("Dodge", IE_Pressed, this, &AHacknSlacksPlayer::OnDodge);
-	InputComponent->BindAction("SwapWeapon", IE_Pressed, this, &AHacknSlacksPlayer::OnSwapWeapon);
-	InputComponent->BindAction("Interact", IE_Pressed, this, &AHacknSlacksPlayer::OnInteract);
-	InputComponent->BindAction("Jump", IE_Pressed, this, &AHacknSlacksPlayer::OnJump);
-	InputComponent->BindAction("Sprint", IE_Pressed, this, &AHacknSlacksPlayer::OnSprint);
-	InputComponent->BindAction("Sprint", IE_Released, this, &AHacknSlacksPlayer::OnEndSprint);
-	InputComponent->BindAction("Shoot", IE_Pressed, this, &AHacknSlacksPlayer::OnShoot);
-	InputComponent->BindAction("Aim", IE_Pressed, this, &AHacknSlacksPlayer::OnAim);
-	InputComponent->BindAction("Ability", IE_Pressed, this, &AHacknSlacksPlayer::OnAbility);
-	InputComponent->BindAction("CharacterOverview", IE_Pressed, this, &AHacknSlacksPlayer::OnCharacterOverview);
-	InputComponent->BindAction("Pause", IE_Pressed, this, &AHacknSlacksPlayer::OnPause).bExecuteWhenPaused = true;
+	InputComponent->BindAxis(FHNSNames::Turn, this, &APawn::AddControllerYawInput);
+	InputComponent->BindAxis(FHNSNames::TurnRate, this, &AHacknSlacksPlayer::TurnAtRate);
+	InputComponent->BindAxis(FHNSNames::LookUp, this, &APawn::AddControllerPitchInput);
+	InputComponent->BindAxis(FHNSNames::LookUpRate, this, &AHacknSlacksPlayer::LookUpAtRate);
+
+	InputComponent->BindAction(FHNSNames::LightAttack, IE_Pressed, this, &AHacknSlacksPlayer::OnLightAttack);
+	InputComponent->BindAction(FHNSNames::HeavyAttack, IE_Pressed, this, &AHacknSlacksPlayer::OnHeavyAttack);
+	InputComponent->BindAction(FHNSNames::LightAttack, IE_Released, this, &AHacknSlacksPlayer::OnReleaseAttack);
+	InputComponent->BindAction(FHNSNames::HeavyAttack, IE_Released, this, &AHacknSlacksPlayer::OnReleaseAttack);
+	//InputComponent->BindAction(FHNSNames::Dodge, IE_Pressed, this, &AHacknSlacksPlayer::OnDodge);
+	InputComponent->BindAction(FHNSNames::SwapWeapon, IE_Pressed, this, &AHacknSlacksPlayer::OnSwapWeapon);
+	InputComponent->BindAction(FHNSNames::Interact, IE_Pressed, this, &AHacknSlacksPlayer::OnInteract);
+	InputComponent->BindAction(FHNSNames::Jump, IE_Pressed, this, &AHacknSlacksPlayer::OnJump);
+	InputComponent->BindAction(FHNSNames::Sprint, IE_Pressed, this, &AHacknSlacksPlayer::OnSprint);
+	InputComponent->BindAction(FHNSNames::Sprint, IE_Released, this, &AHacknSlacksPlayer::OnEndSprint);
+	InputComponent->BindAction(FHNSNames::Shoot, IE_Pressed, this, &AHacknSlacksPlayer::OnShoot);
+	InputComponent->BindAction(FHNSNames::Aim, IE_Pressed, this, &AHacknSlacksPlayer::OnAim);
+	InputComponent->BindAction(FHNSNames::Ability, IE_Pressed, this, &AHacknSlacksPlayer::OnAbility);
+	InputComponent->BindAction(FHNSNames::CharacterOverview, IE_Pressed, this, &AHacknSlacksPlayer::OnCharacterOverview);
+	InputComponent->BindAction(FHNSNames::Pause, IE_Pressed, this, &AHacknSlacksPlayer::OnPause).bExecuteWhenPaused = true;
 }
 
 // input callbacks
 
-void AHacknSlacksPlayer::OnDodge()
-{
-	// change to can dodge function
-	if (!poCurrentAttack && bOnGround && !bDodging && iDodgeCount < iMaxDodgeCount)
-	{
-		// stop attack
-		ResetCombo();
+// attack, dodge and jump presses are buffered and fired by the tick once they are legal
 
-		if (InputComponent)
-		{
-			// set dodge direction
-			oDodgeDir = FVector(InputComponent->GetAxisValue("MoveForward"), InputComponent->GetAxisValue("MoveRight"), 0.0f);
-
-			if (oDodgeDir.IsZero())
-				oDodgeDir = GetActorForwardVector();
-			else
-				oDodgeDir = FRotator(0.0f, FollowCamera->GetComponentRotation().Yaw, 0.0f).RotateVector(oDodgeDir);
-		}
-
-		if (!bDodging)
-		{
-			// save ground friction
-			if (UCharacterMovementComponent* pkCharMovement = GetCharacterMovement())
-			{
-				fSavedFriction = pkCharMovement->GroundFriction;
-				pkCharMovement->GroundFriction = 0.0f;
-			}
-		}
+void AHacknSlacksPlayer::OnLightAttack()
+{
+	oInputBuffer.Press(EBufferedInput::LightAttack);
+}
 
-		bDodging = true;
+void AHacknSlacksPlayer::OnHeavyAttack()
+{
+	oInputBuffer.Press(EBufferedInput::HeavyAttack);
+}
 
-		// full body animation
-		if (bIsLockedOn)
-		{
-			float TempAxisValue = InputComponent->GetAxisValue("MoveRight");
-			if (TempAxisValue >= 0.2f)
-				oDodgeDir = GetActorRightVector();
-			else if (TempAxisValue <= -0.2f)
-				oDodgeDir = -GetActorRightVector();
-		}
-		
-		// turn player towards dodge direction
-		if (pkCharAnim)
-			PlayAnimToAngle(pkCharAnim, EBodyPoses::FullBody, GetDodgeAnim(), 1.0f, false, GetActorRotation().Yaw, FMath::RadiansToDegrees(FMath::Atan2(oDodgeDir.Y, oDodgeDir.X)));
+void AHacknSlacksPlayer::OnReleaseAttack()
+{
+	// a charged attack still in the buffer ends its charge as soon as it fires
+	oInputBuffer.Release(EBufferedInput::LightAttack);
+	oInputBuffer.Release(EBufferedInput::HeavyAttack);
 
-		iDodgeCount++;
+	if (oHot.bCharging)
+		PredictInput(EPredictedInput::EndCharge);
+}
 
-		fDodgeLockTimer = 0.0f;
-	}
+void AHacknSlacksPlayer::OnDodge()
+{
+	oInputBuffer.Press(EBufferedInput::Dodge, GetDodgeInputDir());
 }
 
 /*void AHacknSlacksPlayer::OnSwapWeapon()
@@ -462,7 +683,7 @@ void AHacknSlacksPlayer::OnInteract()
 	// if a chest that can be opened is nearby, open the chest, otherwise pick up the closest item if one is available
 	if (AChest* pkChest = GetClosestOpenableChest())
 		pkChest->Open();
-	else if (pkClosestItem)
+	else if (AItem* pkClosestItem = pkInventory ? pkInventory->pkClosestItem : nullptr)
 	{
 		ResetCombo();
 		pkClosestItem->PickUp(this);
@@ -472,18 +693,25 @@ void AHacknSlacksPlayer::OnInteract()
 // this is when the player pressed the jump key, even if they don't actually jump
 void AHacknSlacksPlayer::OnJump()
 {
+	oInputBuffer.Press(EBufferedInput::Jump);
+}
 
+void AHacknSlacksPlayer::OnEndJump()
+{
+	oInputBuffer.Release(EBufferedInput::Jump);
+
+	StopJumping();
 }
 
 void AHacknSlacksPlayer::OnSprint()
 {
-	if (bOnGround)
-		bSprinting = true;
+	if (oHot.bOnGround)
+		oHot.bSprinting = true;
 }
 
 void AHacknSlacksPlayer::OnEndSprint()
 {
-	bSprinting = false;
+	oHot.bSprinting = false;
 }
 
 void AHacknSlacksPlayer::OnShoot()
@@ -522,7 +750,73 @@ bool AHacknSlacksPlayer::CanPause()
 void AHacknSlacksPlayer::EndDodge()
 {
 	GetCharacterMovement()->GroundFriction = fSavedFriction;
-	bDodging = false;
+	oHot.bDodging = false;
+}
+
+bool AHacknSlacksPlayer::CanDodge() const
+{
+	return !oHot.poCurrentAttack && oHot.bOnGround && !oHot.bDodging && oHot.iDodgeCount < iMaxDodgeCount;
+}
+
+FVector AHacknSlacksPlayer::GetDodgeInputDir()
+{
+	if (!InputComponent)
+		return GetActorForwardVector();
+
+	float fRightAxis = InputComponent->GetAxisValue(FHNSNames::MoveRight);
+
+	// dodge sideways around the locked on target
+	if (pkCameraFollow && pkCameraFollow->bIsLockedOn)
+	{
+		if (fRightAxis >= 0.2f)
+			return GetActorRightVector();
+		else if (fRightAxis <= -0.2f)
+			return -GetActorRightVector();
+	}
+
+	FVector oInputDir = FVector(InputComponent->GetAxisValue(FHNSNames::MoveForward), fRightAxis, 0.0f);
+
+	if (oInputDir.IsZero())
+		return GetActorForwardVector();
+
+	// diagonal stick input is longer than one, dodge speed must not depend on it
+	return FRotator(0.0f, FollowCamera->GetComponentRotation().Yaw, 0.0f).RotateVector(oInputDir.GetSafeNormal());
+}
+
+void AHacknSlacksPlayer::DoDodge(const FVector& oDir)
+{
+	if (!CanDodge())
+		return;
+
+	// stop attack
+	ResetCombo();
+
+	// the direction may come from a client
+	oHot.oDodgeDir = oDir.GetSafeNormal();
+
+	if (oHot.oDodgeDir.IsZero())
+		oHot.oDodgeDir = GetActorForwardVector();
+
+	// replayed frames only rebuild the dodge state, friction and animation were set when it was predicted
+	if (!oHot.bReplayingPrediction)
+	{
+		// save ground friction
+		if (UCharacterMovementComponent* pkCharMovement = GetCharacterMovement())
+		{
+			fSavedFriction = pkCharMovement->GroundFriction;
+			pkCharMovement->GroundFriction = 0.0f;
+		}
+
+		// turn player towards dodge direction
+		if (pkCharAnim)
+			PlayAnimToAngle(pkCharAnim, EBodyPoses::FullBody, GetDodgeAnim(), 1.0f, false, GetActorRotation().Yaw, FAngleMath::YawDegrees(oHot.oDodgeDir));
+	}
+
+	oHot.bDodging = true;
+
+	oHot.iDodgeCount++;
+
+	oHot.fDodgeLockTimer = 0.0f;
 }
 
 void AHacknSlacksPlayer::Jump()
@@ -548,7 +842,7 @@ bool AHacknSlacksPlayer::CanJumpInternal_Implementation() const
 {
 	UAttackDictionary* pkDict = pkWeapon ? pkWeapon->GetAttackDictionary() : pkAttackDict;
 
-	return (!poCurrentAttack || poCurrentAttack->bAllowJump) && (!bOnGround && iJumpCount < iMaxJumpCount || Super::CanJumpInternal_Implementation());
+	return (!oHot.poCurrentAttack || oHot.poCurrentAttack->bAllowJump) && (!oHot.bOnGround && iJumpCount < iMaxJumpCount || Super::CanJumpInternal_Implementation());
 }
 
 // move as part of an attack
@@ -560,18 +854,24 @@ void AHacknSlacksPlayer::AttackMove(FAttackEntry* poAttackEntry)
 	{
 		if (UCharacterMovementComponent* pkCharMove = GetCharacterMovement())
 		{
-			float fRangeToTarget = (pkSoftLockedTarget->GetActorLocation() - GetActorLocation()).Size();
+			float fRangeSquared = (pkSoftLockedTarget->GetActorLocation() - GetActorLocation()).SizeSquared();
 
-			float fVelocityMag = pkCharMove->Velocity.Size();
+			float fVelocitySquared = pkCharMove->Velocity.SizeSquared();
 
-			pkCharMove->Velocity *= FMath::Min(1.0f, fRangeToTarget / fVelocityMag);
+			// only pay for the square root when the attack would carry the player past the target
+			if (fVelocitySquared > fRangeSquared)
+				pkCharMove->Velocity *= FMath::Sqrt(fRangeSquared / fVelocitySquared);
 		}
 	}
 }
 
 void AHacknSlacksPlayer::UpdateCharge(FAttackEntry* poAttackEntry, UCharacterAnimInstance* pkCharAnim)
 {
-	FVector oInputDir = FVector(InputComponent->GetAxisValue("MoveForward"), InputComponent->GetAxisValue("MoveRight"), 0.0f);
+	// the server runs charges for remote players without their input
+	if (!InputComponent || !pkCharAnim)
+		return;
+
+	FVector oInputDir = FVector(InputComponent->GetAxisValue(FHNSNames::MoveForward), InputComponent->GetAxisValue(FHNSNames::MoveRight), 0.0f);
 
 	FVector oTargetDir = oInputDir.IsZero() ? GetActorForwardVector() : FRotator(0.0f, FollowCamera->GetComponentRotation().Yaw, 0.0f).RotateVector(oInputDir);
 
@@ -583,10 +883,10 @@ void AHacknSlacksPlayer::OnEndCharge(FAttackEntry* poAttackEntry, UCharacterAnim
 
 }
 
-/*void AHacknSlacksPlayer::OnPerformAttack(FAttackEntry* poAttackEntry, UCharacterAnimInstance* pkCharAnim, float fPlayRate)
+void AHacknSlacksPlayer::OnPerformAttack(FAttackEntry* poAttackEntry, UCharacterAnimInstance* pkCharAnim, float fPlayRate)
 {
-	// current input direction
-	FVector oInputDir = FVector(InputComponent->GetAxisValue("MoveForward"), InputComponent->GetAxisValue("MoveRight"), 0.0f);
+	// current input direction - none on the server for a remote player
+	FVector oInputDir = InputComponent ? FVector(InputComponent->GetAxisValue(FHNSNames::MoveForward), InputComponent->GetAxisValue(FHNSNames::MoveRight), 0.0f) : FVector::ZeroVector;
 
 	FVector oTargetDir = oInputDir.IsZero() ? GetActorForwardVector() : FRotator(0.0f, FollowCamera->GetComponentRotation().Yaw, 0.0f).RotateVector(oInputDir);
 	
@@ -595,12 +895,12 @@ void AHacknSlacksPlayer::OnEndCharge(FAttackEntry* poAttackEntry, UCharacterAnim
 	
 	//Add anim trails
 	//if (pkWeapon->pkTrails)
-	//pkWeapon->pkTrails->BeginTrails(*socketUpper, *socketLower, ETrailWidthMode_FromCentre, 1);
-}*/
+	//pkWeapon->pkTrails->BeginTrails(FHNSNames::ParticleUpper, FHNSNames::ParticleLower, ETrailWidthMode_FromCentre, 1);
+}
 
 // play an attack animation blended with a turning animation
 // attack to perform, animation instance, player's current facing angle, angle to attack towards
-/*void AHacknSlacksPlayer::PlayAnimToAngle(UCharacterAnimInstance* pkCharAnim, EBodyPoses eBodyPose, UAnimSequenceBase* pkAnim, float fPlayRate, bool bIsAttack, float fCurAngle, float fTargetAngle)
+void AHacknSlacksPlayer::PlayAnimToAngle(UCharacterAnimInstance* pkCharAnim, EBodyPoses eBodyPose, UAnimSequenceBase* pkAnim, float fPlayRate, bool bIsAttack, float fCurAngle, float fTargetAngle)
 {
 	// set target angle for animation
 	pkCharAnim->oStartRot = FRotator(0.0f, fCurAngle, 0.0f);
@@ -622,7 +922,7 @@ void AHacknSlacksPlayer::OnEndCharge(FAttackEntry* poAttackEntry, UCharacterAnim
 		//else							// back
 		//	pkCharAnim->SetAttackBlend(poAttackEntry->pkBackAnim);
 	}
-}*/
+}
 
 // get angle to attack - towards soft lock target or input direction or straight forward
 float AHacknSlacksPlayer::GetAttackAngle(FVector oTargetDir, bool bSoftLock)
@@ -642,16 +942,10 @@ float AHacknSlacksPlayer::GetAttackAngle(FVector oTargetDir, bool bSoftLock)
 			// get angle from player to enemy
 			FVector oFaceDir = pkClosestAngleTarget->GetActorLocation() - GetActorLocation();
 
-			float fAttackDir = FMath::Atan2(oFaceDir.Y, oFaceDir.X);
-
-			// difference in input and soft lock angles
-			float fAngleDiff = FMath::Atan2(oTargetDir.Y, oTargetDir.X) - fAttackDir;
+			float fAttackDir = FAngleMath::Yaw(oFaceDir);
 
-			// prevents angles close to -PI and PI from being regarded as far away from each other
-			if (fAngleDiff < -PI)
-				fAngleDiff += PI * 2;
-			else if (fAngleDiff > PI)
-				fAngleDiff -= PI * 2;
+			// difference in input and soft lock angles, angles close to -PI and PI are close to each other
+			float fAngleDiff = FAngleMath::Diff(FAngleMath::Yaw(oTargetDir), fAttackDir);
 
 			// nearby enemy can be soft locked
 			if (FMath::RadiansToDegrees(FMath::Abs(fAngleDiff)) <= fMaxDirectionalDeviation)
@@ -662,7 +956,7 @@ float AHacknSlacksPlayer::GetAttackAngle(FVector oTargetDir, bool bSoftLock)
 		}
 	}
 
-	return FMath::RadiansToDegrees(FMath::Atan2(oTargetDir.Y, oTargetDir.X));
+	return FAngleMath::YawDegrees(oTargetDir);
 }
 
 // get enemy whose angle from the player is closest to the attack direction
@@ -670,51 +964,31 @@ void AHacknSlacksPlayer::GetClosestAngleEnemy(FVector oTargetDir)
 {
 	pkClosestAngleTarget = nullptr;
 
-	auto pkEnemyIter = apkNearbyEnemies.GetHead();
+	// every player's query reads the same per-frame snapshot of nearby enemies
+	const FTargetingSnapshot* poTargets = FTargetingSnapshot::Get(GetWorld());
 
-	float fMinAngleDiff = 0.0f;
+	if (!poTargets || iPlayerSlot == INDEX_NONE)
+		return;
 
 	// most similar angle from the player to the enemy to this angle becomes the soft locked target
-	float fTargetAngle = FMath::Atan2(oTargetDir.Y, oTargetDir.X);
+	pkClosestAngleTarget = poTargets->GetEnemy(poTargets->FindClosestAngle(iPlayerSlot, GetActorLocation(), FAngleMath::Yaw(oTargetDir)));
+}
+
+void AHacknSlacksPlayer::PruneNearbyEnemies()
+{
+	auto pkEnemyIter = apkNearbyEnemies.GetHead();
 
-	// check each nearby enemy
 	while (pkEnemyIter != nullptr)
 	{
+		auto pkNextEnemy = pkEnemyIter->GetNextNode();
+
 		AEnemy* pkEnemy = pkEnemyIter->GetValue();
 
-		// enemy does not exist or enemy is not alive
-		if (!pkEnemy || pkEnemy->fHealth <= 0.0f)
-		{
-			auto pkNextEnemy = pkEnemyIter->GetNextNode();
+		// enemy does not exist or enemy is not alive, including deaths the queue has not reached yet
+		if (!pkEnemy || pkEnemy->IsPendingKill() || pkEnemy->fHealth <= 0.0f || pkEnemy->IsDying())
 			apkNearbyEnemies.RemoveNode(pkEnemyIter);
-			pkEnemyIter = pkNextEnemy;
 
-			continue;
-		}
-
-		// direction from player to enemy
-		FVector oEnemyDir = pkEnemy->GetActorLocation() - GetActorLocation();
-
-		// difference in angle from player to enemy, to the target angle
-		float fAngleDiff = FMath::Atan2(oEnemyDir.Y, oEnemyDir.X) - fTargetAngle;
-
-		// prevents angles close to -PI and PI from being regarded as far away from each other
-		if (fAngleDiff < -PI)
-			fAngleDiff += PI * 2;
-		else if (fAngleDiff > PI)
-			fAngleDiff -= PI * 2;
-
-		// need a positive value for comparison - closest to zero, sign doesn't matter
-		fAngleDiff = FMath::Abs(fAngleDiff);
-
-		// if first target checked, or target is closer to input angle from player
-		if (pkClosestAngleTarget == nullptr || fAngleDiff < fMinAngleDiff)
-		{
-			pkClosestAngleTarget = pkEnemy;
-			fMinAngleDiff = fAngleDiff;
-		}
-
-		pkEnemyIter = pkEnemyIter->GetNextNode();
+		pkEnemyIter = pkNextEnemy;
 	}
 }
 
@@ -727,18 +1001,8 @@ float AHacknSlacksPlayer::GetAngleDiffToSoftLocked(FVector oTargetDir)
 	// get angle from player to enemy
 	FVector oFaceDir = pkSoftLockedTarget->GetActorLocation() - GetActorLocation();
 
-	float fAttackDir = FMath::Atan2(oFaceDir.Y, oFaceDir.X);
-
-	// difference in input and soft lock angles
-	float fAngleDiff = FMath::Atan2(oTargetDir.Y, oTargetDir.X) - fAttackDir;
-
-	// prevents angles close to -PI and PI from being regarded as far away from each other
-	if (fAngleDiff < -PI)
-		fAngleDiff += PI * 2;
-	else if (fAngleDiff > PI)
-		fAngleDiff -= PI * 2;
-
-	return fAngleDiff;
+	// difference in input and soft lock angles, angles close to -PI and PI are close to each other
+	return FAngleMath::YawDiff(oTargetDir, oFaceDir);
 }
 
 // get dodge animation based on input and facing directions
@@ -749,7 +1013,7 @@ UAnimSequenceBase* AHacknSlacksPlayer::GetDodgeAnim()
 	return pkFrontDodge;
 }
 
-/*void AHacknSlacksPlayer::UpdateBuffs()
+void AHacknSlacksPlayer::UpdateBuffs()
 {
 	float fDelta = GetWorld()->GetDeltaSeconds();
 
@@ -763,15 +1027,26 @@ UAnimSequenceBase* AHacknSlacksPlayer::GetDodgeAnim()
 		{
 			if (!poBuff->Update(fDelta))
 			{
+				int32 iSlot = poBuff->iIndex;
+
+				// widget gets the removal as part of the frame's slot diff
+				oUIEvents.BuffSlotRemoved(iSlot, iActiveBuffs);
+
+				if (bPerBuffEvents)
+					OnRemoveBuff(*poBuff, iBuff);
+
 				iActiveBuffs--;
 
-				OnRemoveBuff(*poBuff, iBuff);
+				ShiftBuffs(iSlot);
+
+				poBuff->iIndex = -1;
 			}
 		}
 	}
-}*/
+}
 
-/*void AHacknSlacksPlayer::ShiftBuffs(int32 iBuffIndex)
+// renumber the slots after a removed buff - the widget relayout happens once when the frame's events are flushed
+void AHacknSlacksPlayer::ShiftBuffs(int32 iBuffIndex)
 {
 	for (int32 iBuff = 0; iBuff < aoBuffs.Num(); iBuff++)
 	{
@@ -779,9 +1054,359 @@ UAnimSequenceBase* AHacknSlacksPlayer::GetDodgeAnim()
 
 		// only update active buffs
 		if (poBuff->bActive && poBuff->iIndex > iBuffIndex)
-			poBuff->ShiftWidget();
+			poBuff->iIndex--;
 	}
-}*/
+}
+
+bool AHacknSlacksPlayer::GetBuffInSlot(int32 iSlot, FBuff& oBuff) const
+{
+	for (const FBuff& oCurBuff : aoBuffs)
+	{
+		if (oCurBuff.bActive && oCurBuff.iIndex == iSlot)
+		{
+			oBuff = oCurBuff;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void AHacknSlacksPlayer::SendCombatState()
+{
+	if (!poCombatChannel.IsValid())
+		poCombatChannel.Reset(new FCombatReplicationChannel());
+
+	TArray<AHackNSlacksCharacter*> apkCharacters;
+
+	for (TActorIterator<AHackNSlacksCharacter> pkCharIter(GetWorld()); pkCharIter; ++pkCharIter)
+		apkCharacters.Add(*pkCharIter);
+
+	TArray<uint8> aiPacket;
+
+	bool bPacket = poCombatChannel->WritePacket(apkCharacters, aiPacket);
+
+	SendCombatDefinitions();
+
+	// bindings go first, they are reliable and only sent for new ids
+	TArray<uint32> aiIDs;
+	TArray<AHackNSlacksCharacter*> apkBound;
+
+	if (poCombatChannel->TakeBindings(aiIDs, apkBound))
+		ClientBindCombatIDs(aiIDs, apkBound);
+
+	if (bPacket)
+		ClientReceiveCombatState(aiPacket);
+}
+
+void AHacknSlacksPlayer::SendCombatDefinitions()
+{
+	FCombatNetDefinitions oDefinitions;
+
+	if (poCombatChannel.IsValid() && poCombatChannel->TakeDefinitions(oDefinitions))
+		ClientDefineCombatEntries(oDefinitions.aiAttacks, oDefinitions.asAttackIds, oDefinitions.aiBuffDefs, oDefinitions.apkBuffClasses);
+}
+
+void AHacknSlacksPlayer::ClientDefineCombatEntries_Implementation(const TArray<int32>& aiAttacks, const TArray<FString>& asAttackIds, const TArray<int32>& aiBuffDefs, const TArray<UClass*>& apkBuffClasses)
+{
+	if (!poCombatReceiver.IsValid())
+		poCombatReceiver.Reset(new FCombatReplicationReceiver());
+
+	FCombatNetDefinitions oDefinitions;
+	oDefinitions.aiAttacks = aiAttacks;
+	oDefinitions.asAttackIds = asAttackIds;
+	oDefinitions.aiBuffDefs = aiBuffDefs;
+	oDefinitions.apkBuffClasses = apkBuffClasses;
+
+	poCombatReceiver->Define(oDefinitions);
+}
+
+void AHacknSlacksPlayer::ClientReceiveCombatState_Implementation(const TArray<uint8>& aiPacket)
+{
+	if (!poCombatReceiver.IsValid())
+		poCombatReceiver.Reset(new FCombatReplicationReceiver());
+
+	TArray<uint32> aiUnknownIDs;
+
+	int32 iSequence = poCombatReceiver->ReadPacket(aiPacket, aiUnknownIDs);
+
+	if (iSequence != INDEX_NONE)
+		ServerAckCombatState(iSequence, aiUnknownIDs);
+}
+
+void AHacknSlacksPlayer::ClientBindCombatIDs_Implementation(const TArray<uint32>& aiIDs, const TArray<AHackNSlacksCharacter*>& apkCharacters)
+{
+	if (!poCombatReceiver.IsValid())
+		poCombatReceiver.Reset(new FCombatReplicationReceiver());
+
+	poCombatReceiver->Bind(aiIDs, apkCharacters);
+}
+
+bool AHacknSlacksPlayer::ServerAckCombatState_Validate(int32 iSequence, const TArray<uint32>& aiUnknownIDs)
+{
+	return iSequence >= 0 && aiUnknownIDs.Num() <= 1024;
+}
+
+void AHacknSlacksPlayer::ServerAckCombatState_Implementation(int32 iSequence, const TArray<uint32>& aiUnknownIDs)
+{
+	if (poCombatChannel.IsValid())
+	{
+		poCombatChannel->Ack(iSequence);
+		poCombatChannel->RequestBindings(aiUnknownIDs);
+	}
+}
+
+bool AHacknSlacksPlayer::PredictInput(EPredictedInput eInput, const FVector& oDir)
+{
+	if (!ApplyPredictedInput(eInput, oDir))
+		return false;
+
+	// the server and standalone games have nothing to predict
+	if (Role == ROLE_Authority)
+		return true;
+
+	if (!poPrediction.IsValid())
+		poPrediction.Reset(new FCombatPredictionBuffer());
+
+	poPrediction->AddInput(eInput, oDir);
+
+	ServerPredictedInput(poPrediction->GetFrame(), (uint8)eInput, oDir);
+
+	return true;
+}
+
+bool AHacknSlacksPlayer::ApplyPredictedInput(EPredictedInput eInput, const FVector& oDir)
+{
+	switch (eInput)
+	{
+	case EPredictedInput::LightAttack:
+	case EPredictedInput::HeavyAttack:
+	{
+		uint32 iAttacks = iAttacksStarted;
+
+		PerformAttack(eInput == EPredictedInput::LightAttack ? EPlayerInputs::LightAttack : EPlayerInputs::HeavyAttack);
+
+		return iAttacks != iAttacksStarted;
+	}
+	case EPredictedInput::EndCharge:
+		if (!oHot.bCharging)
+			return false;
+
+		EndCharge();
+		return true;
+	case EPredictedInput::Dodge:
+		if (!CanDodge())
+			return false;
+
+		DoDodge(oDir);
+		return true;
+	}
+
+	return false;
+}
+
+void AHacknSlacksPlayer::FireBufferedInputs()
+{
+	if (oInputBuffer.Num() == 0)
+		return;
+
+	double fNow = FPlatformTime::Seconds();
+
+	oInputBuffer.DropExpired(fNow, fInputBufferTime);
+
+	for (int32 iInput = 0; iInput < oInputBuffer.Num(); )
+	{
+		// copied, firing can press or release inputs
+		FBufferedInput oInput = oInputBuffer[iInput];
+
+		if (FireBufferedInput(oInput))
+			oInputBuffer.RemoveAt(iInput);
+		else
+			iInput++;
+	}
+}
+
+bool AHacknSlacksPlayer::FireBufferedInput(const FBufferedInput& oInput)
+{
+	switch (oInput.eInput)
+	{
+	case EBufferedInput::LightAttack:
+	case EBufferedInput::HeavyAttack:
+		if (!PredictInput(oInput.eInput == EBufferedInput::LightAttack ? EPredictedInput::LightAttack : EPredictedInput::HeavyAttack))
+			return false;
+
+		// the button was let go while the attack waited
+		if (oInput.bReleased && oHot.bCharging)
+			PredictInput(EPredictedInput::EndCharge);
+
+		return true;
+	case EBufferedInput::Dodge:
+		return PredictInput(EPredictedInput::Dodge, oInput.oDir);
+	case EBufferedInput::Jump:
+		if (!CanJump())
+			return false;
+
+		Jump();
+
+		if (oInput.bReleased)
+			bPendingStopJumping = true;
+
+		return true;
+	}
+
+	return true;
+}
+
+bool AHacknSlacksPlayer::ServerPredictedInput_Validate(int32 iFrame, uint8 iInput, FVector_NetQuantizeNormal oDir)
+{
+	return iFrame >= 0 && iInput < (uint8)EPredictedInput::Count;
+}
+
+void AHacknSlacksPlayer::ServerPredictedInput_Implementation(int32 iFrame, uint8 iInput, FVector_NetQuantizeNormal oDir)
+{
+	ApplyPredictedInput((EPredictedInput)iInput, oDir);
+
+	// time is counted from the first input of a frame, the same as the client's frame
+	if (iFrame != iLastInputFrame)
+	{
+		iLastInputFrame = iFrame;
+		fInputTimeSince = 0.0f;
+	}
+
+	bInputSinceAck = true;
+}
+
+void AHacknSlacksPlayer::SendPredictionAck()
+{
+	FPredictedCombatState oState;
+	oState.Capture(this);
+
+	// timers run the same on both sides, only inputs and state changes the client could not predict need an ack
+	if (!bInputSinceAck && oState.MatchesDiscrete(oLastAckState))
+		return;
+
+	bInputSinceAck = false;
+	oLastAckState = oState;
+
+	uint8 iFlags = (oState.bCharging ? 1 : 0) | (oState.bDodging ? 2 : 0);
+
+	int32 iAttack = FCombatNetDictionaries::Get().oAttacks.Find(oState.poCurrentAttack);
+
+	// the attack index is the server's, the client learns it through the combat channel's definitions
+	if (!poCombatChannel.IsValid())
+		poCombatChannel.Reset(new FCombatReplicationChannel());
+
+	poCombatChannel->DefineAttack(iAttack);
+	SendCombatDefinitions();
+
+	ClientAckPredictedState(iLastInputFrame, fInputTimeSince, iAttack,
+		oState.fComboTimer, oState.fChargeTimer, oState.fDodgeLockTimer, (uint8)FMath::Min(oState.iDodgeCount, 255), iFlags);
+}
+
+void AHacknSlacksPlayer::ClientAckPredictedState_Implementation(int32 iFrame, float fTimeSince, int32 iAttack, float fComboTimer, float fChargeTimer, float fDodgeLockTimer, uint8 iDodgeCount, uint8 iFlags)
+{
+	if (!poPrediction.IsValid())
+		return;
+
+	FPredictedCombatState oServerState;
+
+	oServerState.poCurrentAttack = poCombatReceiver.IsValid() ? poCombatReceiver->FindAttack(iAttack) : nullptr;
+
+	// definition still in flight or its dictionary not registered here, a later ack will cover it
+	if (iAttack != INDEX_NONE && !oServerState.poCurrentAttack)
+	{
+		poPrediction->RecordStale();
+		return;
+	}
+	oServerState.fComboTimer = fComboTimer;
+	oServerState.fChargeTimer = fChargeTimer;
+	oServerState.fDodgeLockTimer = fDodgeLockTimer;
+	oServerState.iDodgeCount = iDodgeCount;
+	oServerState.bCharging = (iFlags & 1) != 0;
+	oServerState.bDodging = (iFlags & 2) != 0;
+
+	ReconcilePrediction(iFrame, fTimeSince, oServerState);
+}
+
+void AHacknSlacksPlayer::ReconcilePrediction(int32 iFrame, float fTimeSince, const FPredictedCombatState& oServerState)
+{
+	int32 iAlignedFrame = poPrediction->FindAlignedFrame(iFrame, fTimeSince);
+
+	if (iAlignedFrame == INDEX_NONE)
+	{
+		poPrediction->RecordStale();
+		return;
+	}
+
+	FPredictedFrame* poAlignedFrame = poPrediction->FindFrame(iAlignedFrame);
+
+	if (poAlignedFrame->oState.Matches(oServerState))
+	{
+		poPrediction->RecordMatch();
+		return;
+	}
+
+	double fStartTime = FPlatformTime::Seconds();
+
+	FAttackEntry* poPredictedAttack = oHot.poCurrentAttack;
+	bool bPredictedDodging = oHot.bDodging;
+
+	// rewind to the server's state and replay only the frames after it
+	poAlignedFrame->oState = oServerState;
+	oServerState.Apply(this);
+
+	oHot.bReplayingPrediction = true;
+
+	int32 iReplayed = 0;
+
+	for (int32 iReplayFrame = iAlignedFrame + 1; iReplayFrame <= poPrediction->GetFrame(); iReplayFrame++)
+	{
+		FPredictedFrame* poFrame = poPrediction->FindFrame(iReplayFrame);
+
+		for (const FPredictedInputEvent& oInput : poFrame->aoInputs)
+			ApplyPredictedInput(oInput.eInput, oInput.oDir);
+
+		// the open frame has not had its combat tick yet
+		if (iReplayFrame < poPrediction->GetFrame())
+		{
+			TickCombat(poFrame->fDeltaTime);
+			poFrame->oState.Capture(this);
+
+			iReplayed++;
+		}
+	}
+
+	oHot.bReplayingPrediction = false;
+
+	// bring animation and movement in line with the corrected state
+	if (oHot.poCurrentAttack != poPredictedAttack)
+	{
+		if (!oHot.poCurrentAttack)
+			ResetCombo();
+		else
+		{
+			// the replay left the predicted attack's sweeps alone
+			for (UAttackCollider* pkCollider : apkAttackColliders)
+				if (pkCollider)
+					pkCollider->SetColliderActive(false);
+
+			EndAttackSweeps();
+
+			if (pkCharAnim)
+				OnPerformAttack(oHot.poCurrentAttack, pkCharAnim, oHot.bCharging ? oHot.poCurrentAttack->fPlayRate * 0.1f / oHot.poCurrentAttack->fMaxCharge : oHot.poCurrentAttack->fPlayRate);
+		}
+	}
+
+	if (oHot.bDodging != bPredictedDodging)
+	{
+		bool bCorrectedDodging = oHot.bDodging;
+
+		oHot.bDodging = bPredictedDodging;
+		SetDodging(bCorrectedDodging);
+	}
+
+	poPrediction->RecordCorrection(iReplayed, FPlatformTime::Seconds() - fStartTime);
+}
 
 APlayerController* AHacknSlacksPlayer::GetPlayerController()
 {
@@ -789,19 +1414,19 @@ APlayerController* AHacknSlacksPlayer::GetPlayerController()
 }
 
 // update shader parameters
-/*void AHacknSlacksPlayer::UpdateFX()
+void AHacknSlacksPlayer::UpdateFX()
 {
 	float fHealthFactor = fHealth / fMaxHealth;
 
-	UHNSGameInstance::SetShaderValue("Saturation", fHealthFactor);
-	UHNSGameInstance::SetShaderValue("VignetteIntensity", 1.0f - fHealthFactor);
-}*/
+	UHNSGameInstance::SetShaderValue(FHNSNames::Saturation, fHealthFactor);
+	UHNSGameInstance::SetShaderValue(FHNSNames::VignetteIntensity, 1.0f - fHealthFactor);
+}
 
 void AHacknSlacksPlayer::PitchAutoAdjustment(float DeltaTime)
 {
 	if (InputComponent)
 	{
-		if (InputComponent->GetAxisValue("MoveForward") > 0.025f || InputComponent->GetAxisValue("MoveForward") < -0.025f)
+		if (InputComponent->GetAxisValue(FHNSNames::MoveForward) > 0.025f || InputComponent->GetAxisValue(FHNSNames::MoveForward) < -0.025f)
 			bMoving = true;
 		else
 		{
@@ -7,11 +7,18 @@
 #include "WeaponTypes.h"
 #include "BodyPoses.h"
 #include "Sheath.h"
+#include "SheathMeshes.h"
+#include "CheckpointSnapshot.h"
+#include "UIEventBus.h"
+#include "CombatReplication.h"
+#include "CombatPrediction.h"
+#include "InputBuffer.h"
 #include "HackNSlacksCharacter.h"
 #include "GameFramework/Character.h"
 #include "HacknSlacksPlayer.generated.h"
 
 class AEnemy;
+class UStreamingPredictorComponent;
 struct FAbilityData;
 	
 UCLASS(config = Game)
@@ -19,6 +26,9 @@ class HACKNSLACKS_API AHacknSlacksPlayer : public AHackNSlacksCharacter
 {
 	GENERATED_BODY()
 
+	friend struct FCheckpointSnapshot;
+	friend class UCrowdStressCommandlet;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
@@ -27,6 +37,10 @@ class HACKNSLACKS_API AHacknSlacksPlayer : public AHackNSlacksCharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
 
+	/** Loads level chunks ahead of the player's movement */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Streaming, meta = (AllowPrivateAccess = "true"))
+	UStreamingPredictorComponent* StreamingPredictor;
+
 public:
 	AHacknSlacksPlayer(const FObjectInitializer& ObjectInitializer);
 
@@ -34,11 +48,37 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns StreamingPredictor subobject **/
+	FORCEINLINE UStreamingPredictorComponent* GetStreamingPredictor() const { return StreamingPredictor; }
+	/** Returns the last position the player was standing on the ground **/
+	FORCEINLINE const FVector& GetLastGroundPosition() const { return oLastGroundPosition; }
+
+	// local player in a split-screen slot, nullptr if the slot is empty
+	UFUNCTION(BlueprintCallable, Category = Player, meta = (WorldContext = "pkWorldContext"))
+	static AHacknSlacksPlayer* GetPlayerInSlot(UObject* pkWorldContext, int32 iSlot);
+
+	// player registry slot, the local player's controller id - INDEX_NONE until a local player possesses the pawn
+	FORCEINLINE int32 GetPlayerSlot() const { return iPlayerSlot; }
+
+	FORCEINLINE const TTrackedList<AEnemy*, ECombatMemTag::NearbyEnemies>& GetNearbyEnemies() const { return apkNearbyEnemies; }
+
+	// remove dead and destroyed enemies from the nearby list
+	void PruneNearbyEnemies();
 
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PossessedBy(AController* NewController) override;
+
+	virtual void PawnClientRestart() override;
+
+	virtual void UnPossessed() override;
+
 	virtual void TickActor(float DeltaTime, enum ELevelTick TickType, FActorTickFunction& ThisTickFunction) override;
 
+	virtual void OnCombatStep(float fStepTime) override;
+
 	virtual void ReceiveAnyDamage(float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
 
 	virtual float SetHealth(float fNewHealth) override;
@@ -66,9 +106,14 @@ public:
 	UFUNCTION()
 	void SoftLockSphereEndOverlap(class AActor* pkOther, class UPrimitiveComponent* pkOtherComp, int32 iOtherBodyIndex);
 
+	// legacy event for each added buff, only sent when bPerBuffEvents is set - widgets should use OnBuffSlotsChanged
 	UFUNCTION(BlueprintImplementableEvent, Category = Buff)
 	void OnAddBuff(const FBuff& oBuff);
 
+	// keep sending OnAddBuff and OnRemoveBuff for every change, for blueprints not yet moved to OnBuffSlotsChanged
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Buff)
+	bool bPerBuffEvents;
+
 	FBuff& AddBuff(TSubclassOf<UBuffDef> pkBuffDef, float fIntensity, float fDuration, int32 iTickCount) override;
 
 	// increase combo counter
@@ -102,9 +147,53 @@ public:
 	UFUNCTION(BlueprintImplementableEvent, Category = Player)
 	void OnLevelStreamed();
 
+	// set where the player respawns and snapshot the player and level state there
+	UFUNCTION(BlueprintCallable, Category = Player)
+	void SetCheckpoint(const FTransform& oCheckpoint);
+
+	// return the player and level to the last checkpoint without reloading - returns false if no checkpoint was reached
+	UFUNCTION(BlueprintCallable, Category = Player)
+	bool RespawnAtCheckpoint();
+
+	// restore the checkpoint snapshot written to disk, used to resume after a crash
+	UFUNCTION(BlueprintCallable, Category = Player)
+	bool ResumeFromSavedCheckpoint();
+
+	// buff bar changes for the frame - slots removed from the previous layout, highest first, and slots added to the new layout
+	UFUNCTION(BlueprintImplementableEvent, Category = Buff)
+	void OnBuffSlotsChanged(const TArray<int32>& aiRemovedSlots, const TArray<int32>& aiAddedSlots);
+
+	// get the active buff shown in a buff bar slot
+	UFUNCTION(BlueprintCallable, Category = Buff)
+	bool GetBuffInSlot(int32 iSlot, FBuff& oBuff) const;
+
 	// shift active buffs left when a buff is removed
 	void ShiftBuffs(int32 iIndex);
 
+	// server to owning client - bit packed combat state of the characters that changed since the last acked packet, by channel id
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveCombatState(const TArray<uint8>& aiPacket);
+
+	// server to owning client - the characters behind new channel ids, sent once per id and again if the client asks
+	UFUNCTION(Client, Reliable)
+	void ClientBindCombatIDs(const TArray<uint32>& aiIDs, const TArray<AHackNSlacksCharacter*>& apkCharacters);
+
+	// server to owning client - what new attack and buff def indices stand for, sent once before they are used
+	UFUNCTION(Client, Reliable)
+	void ClientDefineCombatEntries(const TArray<int32>& aiAttacks, const TArray<FString>& asAttackIds, const TArray<int32>& aiBuffDefs, const TArray<UClass*>& apkBuffClasses);
+
+	// owning client to server - packet arrived and can be used as the delta baseline, aiUnknownIDs had no actor on the client
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerAckCombatState(int32 iSequence, const TArray<uint32>& aiUnknownIDs);
+
+	// owning client to server - an attack or dodge input the client already ran, with the client frame it was run on
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerPredictedInput(int32 iFrame, uint8 iInput, FVector_NetQuantizeNormal oDir);
+
+	// server to owning client - combat state fTimeSince seconds after the inputs of iFrame were applied
+	UFUNCTION(Client, Unreliable)
+	void ClientAckPredictedState(int32 iFrame, float fTimeSince, int32 iAttack, float fComboTimer, float fChargeTimer, float fDodgeLockTimer, uint8 iDodgeCount, uint8 iFlags);
+
 	// convenience function to access the player's controller as a player controller
 	UFUNCTION(BlueprintCallable, Category = Player)
 	APlayerController* GetPlayerController();
@@ -116,12 +205,6 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Player)
 	USphereComponent* pkSoftLockSphere;
 
-	FName* socketUpper;
-	
-	FName* socketLower;
-	
-	FName* socketFront;
-	
 	// number of buffs active on the player
 	UPROPERTY(BlueprintReadWrite, Category = Buff)
 	int32 iActiveBuffs;
@@ -129,16 +212,30 @@ public:
 	UPROPERTY(EditAnywhere, Category = Sheath)
 	FSheath aoSheaths[(int32)ESheaths::Count + 1];
 
+	// sheath socket copies of each assigned weapon's meshes - same slots as aoSheaths, so any sheath index is valid for both
+	UPROPERTY()
+	FSheathMeshes aoSheathMeshes[(int32)ESheaths::Count + 1];
+
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 	// End of APawn interface
 
+	// the player is set up in BeginPlay, it is spawned alone and needed straight away
+	virtual bool ShouldTimeSliceInit() const override;
+
+	// the player respawns at a checkpoint, it is never ragdolled and destroyed
+	virtual bool UsesDeathQueue() const override;
+
 	// input callbacks
+	virtual void OnLightAttack() override;
+	virtual void OnHeavyAttack() override;
+	void OnReleaseAttack();
 	void OnDodge();
 	void OnSwapWeapon();
 	void OnInteract();
 	void OnJump();
+	void OnEndJump();
 	void OnSprint();
 	void OnEndSprint();
 	void OnShoot();
@@ -151,6 +248,14 @@ protected:
 
 	void EndDodge();
 
+	bool CanDodge() const;
+
+	// dodge direction from the movement input and camera
+	FVector GetDodgeInputDir();
+
+	// start a dodge in a direction - shared by local input, server input and replay
+	void DoDodge(const FVector& oDir);
+
 	virtual void Jump() override;
 
 	// when the player touches the ground after being airborne
@@ -185,9 +290,70 @@ protected:
 	// get which animation to use for the dodge
 	UAnimSequenceBase* GetDodgeAnim();
 
+	// one time setup for a weapon placed in a sheath - attaches it to the hand and builds its sheath meshes
+	void RegisterSheathWeapon(AWeapon* pkSheathWeapon);
+
+	// show a weapon in the hand or in its sheath by toggling visibility and collision only
+	void ShowWeaponInHand(AWeapon* pkSheathWeapon, bool bInHand);
+
+	// combo and buff notifications waiting to be sent to the widgets at the end of the frame
+	FUIEventBus oUIEvents;
+
+	// send every character's combat state to this player's client
+	void SendCombatState();
+
+	// send definitions the combat channel queued, ahead of anything that uses them
+	void SendCombatDefinitions();
+
+	// server side stream to this player's client, created on the first send
+	TUniquePtr<FCombatReplicationChannel> poCombatChannel;
+
+	// client side stream from the server
+	TUniquePtr<FCombatReplicationReceiver> poCombatReceiver;
+
+	// run an attack or dodge input now, and on a client also send it to the server - returns false if the input was not legal, it is then not sent
+	bool PredictInput(EPredictedInput eInput, const FVector& oDir = FVector::ZeroVector);
+
+	// attacks are judged against the combo timer at the last combat step, the same on client and server
+	bool ApplyPredictedInput(EPredictedInput eInput, const FVector& oDir);
+
+	// fire buffered presses that are legal now, oldest first
+	void FireBufferedInputs();
+
+	// returns false to keep the press buffered
+	bool FireBufferedInput(const FBufferedInput& oInput);
+
+	// attack, dodge and jump presses waiting to become legal
+	FCombatInputBuffer oInputBuffer;
+
+	// a buffered jump fired after its button was let go, the jump is stopped on the next tick
+	bool bPendingStopJumping;
+
+	// compare the server's state with the prediction, rewind and replay the frames after it if they differ
+	void ReconcilePrediction(int32 iFrame, float fTimeSince, const FPredictedCombatState& oServerState);
+
+	// send the combat state after the last client input, if it changed since the last ack
+	void SendPredictionAck();
+
+	// client side history of predicted frames, created on the first predicted input
+	TUniquePtr<FCombatPredictionBuffer> poPrediction;
+
+	// server side - client frame of the last input received, INDEX_NONE before any
+	int32 iLastInputFrame;
+
+	// server side - combat time run since the inputs of iLastInputFrame
+	float fInputTimeSince;
+
+	// server side - an input arrived since the last ack
+	bool bInputSinceAck;
+
+	// server side - state sent in the last ack
+	FPredictedCombatState oLastAckState;
+
 	UFUNCTION(BlueprintCallable, Category = Buff)
 	void UpdateBuffs() override;
 
+	// legacy event for each removed buff, only sent when bPerBuffEvents is set
 	UFUNCTION(BlueprintImplementableEvent, Category = Buff)
 	void OnRemoveBuff(const FBuff& oBuff, int32 iIndex);
 
@@ -197,6 +363,11 @@ protected:
 	// Testing for camera auto pitch adjustments
 	void PitchAutoAdjustment(float DeltaTime);
 
+	// deferred tasks - run by the scheduler instead of every tick
+	void UpdateSoftLockArrow(float fElapsed);
+
+	void UpdateLookRotation(float fElapsed);
+
 	bool bMoving;
 	bool bPitchAdjust;
 	bool bDisablePitchAdjust;
@@ -219,6 +390,10 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combo)
 	float fComboNoHitDuration;
 
+	// seconds an attack, dodge or jump press waits to become legal before it is dropped
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combo)
+	float fInputBufferTime;
+
 	// timer for duration
 	UPROPERTY(BlueprintReadWrite, Category = Combo)
 	float fComboNoHitTimer;
@@ -246,6 +421,9 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Player)
 	FTransform oLastCheckpoint;
 
+	// state captured when the last checkpoint was reached
+	FCheckpointSnapshot oCheckpointSnapshot;
+
 	// MOVEMENT
 
 	// speed at which the player moves while running
@@ -303,7 +481,14 @@ protected:
 	AEnemy* pkSoftLockedTarget;
 
 	// list of nearby enemies for directional attacks
-	TDoubleLinkedList<AEnemy*> apkNearbyEnemies;
+	TTrackedList<AEnemy*, ECombatMemTag::NearbyEnemies> apkNearbyEnemies;
+
+	int32 iPlayerSlot;
+
+	// take the local player's slot in the registry, remote and AI controlled pawns have none
+	void RegisterPlayerSlot();
+
+	void UnregisterPlayerSlot();
 
 	// arrow to indicate which enemy is the soft lock target
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Visual)
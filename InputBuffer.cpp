@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "InputBuffer.h"
+
+FCombatInputBuffer::FCombatInputBuffer()
+{
+}
+
+void FCombatInputBuffer::Press(EBufferedInput eInput, const FVector& oDir)
+{
+	for (int32 iInput = 0; iInput < aoInputs.Num(); iInput++)
+	{
+		if (aoInputs[iInput].eInput == eInput)
+		{
+			aoInputs.RemoveAt(iInput);
+			break;
+		}
+	}
+
+	FBufferedInput oInput;
+	oInput.eInput = eInput;
+	oInput.oDir = oDir;
+	oInput.fPressTime = FPlatformTime::Seconds();
+	oInput.bReleased = false;
+
+	aoInputs.Add(oInput);
+}
+
+void FCombatInputBuffer::Release(EBufferedInput eInput)
+{
+	for (FBufferedInput& oInput : aoInputs)
+		if (oInput.eInput == eInput)
+			oInput.bReleased = true;
+}
+
+void FCombatInputBuffer::DropExpired(double fNow, float fMaxWait)
+{
+	for (int32 iInput = aoInputs.Num() - 1; iInput >= 0; iInput--)
+		if (fNow - aoInputs[iInput].fPressTime > fMaxWait)
+			aoInputs.RemoveAt(iInput);
+}
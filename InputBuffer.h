@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// presses that wait in the buffer until they are legal
+enum class EBufferedInput : uint8
+{
+	LightAttack,
+	HeavyAttack,
+	Dodge,
+	Jump,
+	Count
+};
+
+struct FBufferedInput
+{
+	EBufferedInput eInput;
+
+	// dodge direction when pressed
+	FVector oDir;
+
+	// platform seconds when the press was read
+	double fPressTime;
+
+	// the button was let go before the input fired
+	bool bReleased;
+};
+
+// attack, dodge and jump presses that fire on the first frame they are legal instead of being dropped - stamped with
+// the time they were read so stale presses expire
+class HACKNSLACKS_API FCombatInputBuffer
+{
+public:
+	FCombatInputBuffer();
+
+	// a newer press of the same input replaces the buffered one
+	void Press(EBufferedInput eInput, const FVector& oDir = FVector::ZeroVector);
+
+	void Release(EBufferedInput eInput);
+
+	// drop presses that have waited longer than fMaxWait seconds
+	void DropExpired(double fNow, float fMaxWait);
+
+	FORCEINLINE int32 Num() const { return aoInputs.Num(); }
+
+	FORCEINLINE const FBufferedInput& operator[](int32 iInput) const { return aoInputs[iInput]; }
+
+	FORCEINLINE void RemoveAt(int32 iInput) { aoInputs.RemoveAt(iInput); }
+
+	FORCEINLINE void Empty() { aoInputs.Reset(); }
+
+private:
+	// oldest press first
+	TArray<FBufferedInput, TInlineAllocator<(int32)EBufferedInput::Count>> aoInputs;
+};
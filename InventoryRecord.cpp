@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "Item.h"
+#include "InventoryRecord.h"
+
+int32 FInventory::Add(TSubclassOf<AItem> pkItemClass, int32 iAddCount)
+{
+	if (!pkItemClass || iAddCount <= 0)
+		return iAddCount;
+
+	// a stack size of zero or less set in the editor would never finish adding
+	const int32 iStackSize = FMath::Max(iMaxStack, 1);
+
+	// top up existing stacks of the same item first
+	for (int32 iRecord = 0; iRecord < aoRecords.Num() && iAddCount > 0; iRecord++)
+	{
+		FInventoryRecord& oRecord = aoRecords[iRecord];
+
+		if (!oRecord.IsFree() && oRecord.pkItemClass == pkItemClass && oRecord.iCount < iStackSize)
+		{
+			int32 iStack = FMath::Min(iAddCount, iStackSize - oRecord.iCount);
+
+			oRecord.iCount += iStack;
+			iAddCount -= iStack;
+		}
+	}
+
+	// start new stacks for whatever is left
+	while (iAddCount > 0)
+	{
+		FInventoryRecord& oRecord = aoRecords[AllocRecord()];
+
+		oRecord.pkItemClass = pkItemClass;
+		oRecord.iCount = FMath::Min(iAddCount, iStackSize);
+
+		iAddCount -= oRecord.iCount;
+	}
+
+	return iAddCount;
+}
+
+int32 FInventory::Remove(int32 iRecord, int32 iRemoveCount)
+{
+	if (!IsValidRecord(iRecord) || iRemoveCount <= 0)
+		return 0;
+
+	FInventoryRecord& oRecord = aoRecords[iRecord];
+
+	int32 iRemoved = FMath::Min(iRemoveCount, oRecord.iCount);
+
+	oRecord.iCount -= iRemoved;
+
+	// stack is empty, return the slot to the pool
+	if (oRecord.IsFree())
+	{
+		oRecord.pkItemClass = nullptr;
+		oRecord.iNextFree = iFreeHead;
+
+		iFreeHead = iRecord;
+		iUsedRecords--;
+	}
+
+	return iRemoved;
+}
+
+int32 FInventory::Count(TSubclassOf<AItem> pkItemClass) const
+{
+	int32 iTotal = 0;
+
+	for (const FInventoryRecord& oRecord : aoRecords)
+		if (!oRecord.IsFree() && oRecord.pkItemClass == pkItemClass)
+			iTotal += oRecord.iCount;
+
+	return iTotal;
+}
+
+AItem* FInventory::SpawnItem(UWorld* pkWorld, int32 iRecord, const FTransform& oTransform) const
+{
+	if (!pkWorld || !IsValidRecord(iRecord))
+		return nullptr;
+
+	FActorSpawnParameters oParams;
+	oParams.bNoCollisionFail = true;
+
+	return pkWorld->SpawnActor<AItem>(aoRecords[iRecord].pkItemClass, oTransform, oParams);
+}
+
+void FInventory::Empty()
+{
+	aoRecords.Empty();
+
+	iFreeHead = INDEX_NONE;
+	iUsedRecords = 0;
+}
+
+void FInventory::PostSerialize(const FArchive& Ar)
+{
+	if (Ar.IsLoading())
+		RebuildPool();
+}
+
+int32 FInventory::AllocRecord()
+{
+	iUsedRecords++;
+
+	// reuse a freed slot
+	if (iFreeHead != INDEX_NONE)
+	{
+		int32 iRecord = iFreeHead;
+
+		iFreeHead = aoRecords[iRecord].iNextFree;
+		aoRecords[iRecord].iNextFree = INDEX_NONE;
+
+		return iRecord;
+	}
+
+	// grow the pool in blocks so looting does not reallocate on every pick up
+	if (aoRecords.Num() == aoRecords.Max())
+		aoRecords.Reserve(aoRecords.Num() + 16);
+
+	return aoRecords.Add(FInventoryRecord());
+}
+
+void FInventory::RebuildPool()
+{
+	iFreeHead = INDEX_NONE;
+	iUsedRecords = 0;
+
+	// walk backwards so the lowest free slot is reused first
+	for (int32 iRecord = aoRecords.Num() - 1; iRecord >= 0; iRecord--)
+	{
+		FInventoryRecord& oRecord = aoRecords[iRecord];
+
+		if (oRecord.IsFree())
+		{
+			oRecord.iCount = 0;
+			oRecord.pkItemClass = nullptr;
+			oRecord.iNextFree = iFreeHead;
+
+			iFreeHead = iRecord;
+		}
+		else
+		{
+			oRecord.iNextFree = INDEX_NONE;
+
+			iUsedRecords++;
+		}
+	}
+}
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "InventoryRecord.generated.h"
+
+class AItem;
+
+// compact stand-in for an item actor while it sits in an inventory
+USTRUCT(BlueprintType)
+struct FInventoryRecord
+{
+	GENERATED_USTRUCT_BODY()
+
+	FInventoryRecord() : pkItemClass(nullptr), iCount(0), iNextFree(INDEX_NONE) {}
+
+	// item actor to spawn when the record is dropped or shown
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Item)
+	TSubclassOf<AItem> pkItemClass;
+
+	// number of items stacked in this record - zero means the slot is free
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Item)
+	int32 iCount;
+
+	// next free slot in the pool while this slot is unused
+	int32 iNextFree;
+
+	FORCEINLINE bool IsFree() const { return iCount <= 0; }
+};
+
+// pooled list of inventory records - freed slots are reused so record indices stay stable
+USTRUCT(BlueprintType)
+struct FInventory
+{
+	GENERATED_USTRUCT_BODY()
+
+	FInventory() : iMaxStack(99), iFreeHead(INDEX_NONE), iUsedRecords(0) {}
+
+	// add items of a class, stacking onto existing records first and starting as many records as needed - returns how many
+	// could not be added, which is only ever non-zero for a null class
+	int32 Add(TSubclassOf<AItem> pkItemClass, int32 iAddCount = 1);
+
+	// remove items from a record - returns how many were removed
+	int32 Remove(int32 iRecord, int32 iRemoveCount = 1);
+
+	// total number of items of a class in the inventory
+	int32 Count(TSubclassOf<AItem> pkItemClass) const;
+
+	// spawn a real item actor for a record, used when an item is dropped or needs to be shown
+	AItem* SpawnItem(UWorld* pkWorld, int32 iRecord, const FTransform& oTransform) const;
+
+	// remove every record and release the pool
+	void Empty();
+
+	// free list and used count are not saved, rebuild them from the records after loading
+	void PostSerialize(const FArchive& Ar);
+
+	FORCEINLINE int32 Num() const { return iUsedRecords; }
+
+	FORCEINLINE bool IsValidRecord(int32 iRecord) const { return aoRecords.IsValidIndex(iRecord) && !aoRecords[iRecord].IsFree(); }
+
+	FORCEINLINE const FInventoryRecord& GetRecord(int32 iRecord) const { return aoRecords[iRecord]; }
+
+	// maximum number of items of one class in a single record, treated as at least 1
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Item)
+	int32 iMaxStack;
+
+	// record pool, includes free slots
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Item)
+	TArray<FInventoryRecord> aoRecords;
+
+private:
+	// take a slot from the free list or grow the pool
+	int32 AllocRecord();
+
+	void RebuildPool();
+
+	// head of the free slot list
+	int32 iFreeHead;
+
+	// number of records holding items
+	int32 iUsedRecords;
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventory> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithPostSerialize = true
+	};
+};
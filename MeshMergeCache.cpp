@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "SkeletalMeshMerge.h"
+#include "HackNSlacksCharacter.h"
+#include "MeshMergeCache.h"
+
+FMeshMergeCache::FMeshMergeCache()
+{
+	fFrameBudget = 0.002f;
+}
+
+FMeshMergeCache& FMeshMergeCache::Get()
+{
+	static FMeshMergeCache oCache;
+
+	return oCache;
+}
+
+void FMeshMergeCache::RequestMerge(AHackNSlacksCharacter* pkCharacter)
+{
+	apkRequests.AddUnique(pkCharacter);
+}
+
+USkeletalMesh* FMeshMergeCache::FindOrMerge(const TArray<USkeletalMesh*>& apkMeshes)
+{
+	if (apkMeshes.Num() == 0)
+		return nullptr;
+
+	// order matters, the same meshes in a different order give different material sections
+	uint32 iHash = 0;
+
+	for (USkeletalMesh* pkMesh : apkMeshes)
+		iHash = HashCombine(iHash, GetTypeHash(pkMesh));
+
+	for (auto kIter = kMergedMeshes.CreateKeyIterator(iHash); kIter; ++kIter)
+	{
+		const FMergedMesh& oEntry = kIter.Value();
+
+		bool bSame = oEntry.apkSources.Num() == apkMeshes.Num();
+
+		for (int32 iMesh = 0; bSame && iMesh < apkMeshes.Num(); iMesh++)
+			bSame = oEntry.apkSources[iMesh].Get() == apkMeshes[iMesh];
+
+		if (bSame && oEntry.bFailed)
+			return nullptr;
+
+		// no character uses the merge anymore
+		if (!oEntry.bFailed && !oEntry.pkMerged.IsValid())
+		{
+			kIter.RemoveCurrent();
+			continue;
+		}
+
+		if (bSame)
+			return oEntry.pkMerged.Get();
+	}
+
+	FMergedMesh oEntry;
+	oEntry.bFailed = false;
+
+	for (USkeletalMesh* pkMesh : apkMeshes)
+		oEntry.apkSources.Add(pkMesh);
+
+	USkeletalMesh* pkMerged = NewObject<USkeletalMesh>(GetTransientPackage());
+	pkMerged->Skeleton = apkMeshes[0]->Skeleton;
+
+	TArray<FSkelMeshMergeSectionMapping> aoSectionMappings;
+
+	FSkeletalMeshMerge oMerger(pkMerged, apkMeshes, aoSectionMappings, 0);
+
+	if (!oMerger.DoMerge())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to merge %d meshes for %s"), apkMeshes.Num(), *apkMeshes[0]->GetName());
+
+		// every character with the same gear would retry the same merge
+		oEntry.bFailed = true;
+		kMergedMeshes.Add(iHash, oEntry);
+
+		return nullptr;
+	}
+
+	oEntry.pkMerged = pkMerged;
+
+	kMergedMeshes.Add(iHash, oEntry);
+
+	return pkMerged;
+}
+
+void FMeshMergeCache::Tick(float DeltaTime)
+{
+	double fStartTime = FPlatformTime::Seconds();
+
+	int32 iHandled = 0;
+
+	// characters in the middle of an attack, tried again next frame
+	TArray<TWeakObjectPtr<AHackNSlacksCharacter>> apkWaiting;
+
+	// start requests oldest first until the budget is used, cache hits are cheap so several usually fit - the budget is
+	// only a per-request cap, a merge that has started always finishes
+	while (apkRequests.Num() > 0 && (iHandled == 0 || FPlatformTime::Seconds() - fStartTime < fFrameBudget))
+	{
+		TWeakObjectPtr<AHackNSlacksCharacter> pkCharacter = apkRequests[0];
+
+		apkRequests.RemoveAt(0, 1, false);
+
+		if (pkCharacter.IsValid() && !pkCharacter->IsPendingKill())
+		{
+			if (pkCharacter->UpdateMergedMesh())
+				iHandled++;
+			else
+				apkWaiting.Add(pkCharacter);
+		}
+	}
+
+	apkRequests.Append(apkWaiting);
+}
+
+bool FMeshMergeCache::IsTickable() const
+{
+	return apkRequests.Num() > 0;
+}
+
+TStatId FMeshMergeCache::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FMeshMergeCache, STATGROUP_Tickables);
+}
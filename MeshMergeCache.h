@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Tickable.h"
+
+class AHackNSlacksCharacter;
+
+// merges body part and gear skeletal meshes into one mesh per combination, and spreads the merges requested by characters over several frames
+class HACKNSLACKS_API FMeshMergeCache : public FTickableGameObject
+{
+public:
+	FMeshMergeCache();
+
+	static FMeshMergeCache& Get();
+
+	// merge the character's meshes on a later frame - requests already queued for the character are kept
+	void RequestMerge(AHackNSlacksCharacter* pkCharacter);
+
+	// merged mesh for meshes that share a skeleton, built the first time the combination is seen - nullptr if the merge failed,
+	// failed combinations are remembered and not merged again
+	USkeletalMesh* FindOrMerge(const TArray<USkeletalMesh*>& apkMeshes);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	// seconds of merging after which no more requests are started this frame - checked between requests, so a single
+	// uncached merge can run past it
+	float fFrameBudget;
+
+private:
+	struct FMergedMesh
+	{
+		// the meshes merged, in order - compared on a hash hit so combinations with the same hash are not mixed up
+		TArray<TWeakObjectPtr<USkeletalMesh>> apkSources;
+
+		TWeakObjectPtr<USkeletalMesh> pkMerged;
+
+		// the merge failed, pkMerged is never set
+		bool bFailed;
+	};
+
+	TArray<TWeakObjectPtr<AHackNSlacksCharacter>> apkRequests;
+
+	// merged meshes by hash of their source meshes - kept alive by the characters using them
+	TMultiMap<uint32, FMergedMesh> kMergedMeshes;
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// one T per world, created on first use and destroyed when the world is cleaned up - game thread only
+// T is constructed with the world it belongs to
+template<typename T>
+class TPerWorld
+{
+public:
+	// nullptr only if pkWorld is
+	static T* Get(UWorld* pkWorld)
+	{
+		if (!pkWorld)
+			return nullptr;
+
+		TMap<TWeakObjectPtr<UWorld>, TSharedPtr<T>>& kInstances = GetInstances();
+
+		if (TSharedPtr<T>* poInstance = kInstances.Find(pkWorld))
+			return poInstance->Get();
+
+		static bool bRegistered = false;
+
+		if (!bRegistered)
+		{
+			FWorldDelegates::OnWorldCleanup.AddStatic(&OnWorldCleanup);
+			bRegistered = true;
+		}
+
+		TSharedPtr<T> poInstance = MakeShareable(new T(pkWorld));
+		kInstances.Add(pkWorld, poInstance);
+
+		return poInstance.Get();
+	}
+
+	// existing instance without creating one
+	static T* Find(UWorld* pkWorld)
+	{
+		TSharedPtr<T>* poInstance = pkWorld ? GetInstances().Find(pkWorld) : nullptr;
+
+		return poInstance ? poInstance->Get() : nullptr;
+	}
+
+	// every live instance, for console commands
+	static const TMap<TWeakObjectPtr<UWorld>, TSharedPtr<T>>& GetAll()
+	{
+		return GetInstances();
+	}
+
+private:
+	static TMap<TWeakObjectPtr<UWorld>, TSharedPtr<T>>& GetInstances()
+	{
+		static TMap<TWeakObjectPtr<UWorld>, TSharedPtr<T>> kInstances;
+
+		return kInstances;
+	}
+
+	static void OnWorldCleanup(UWorld* pkWorld, bool bSessionEnded, bool bCleanupResources)
+	{
+		GetInstances().Remove(pkWorld);
+	}
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HacknSlacksPlayer.h"
+#include "PerWorld.h"
+#include "PlayerRegistry.h"
+
+FPlayerRegistry::FPlayerRegistry(UWorld* pkWorld)
+{
+}
+
+FPlayerRegistry* FPlayerRegistry::Get(UWorld* pkWorld)
+{
+	return TPerWorld<FPlayerRegistry>::Get(pkWorld);
+}
+
+int32 FPlayerRegistry::Register(AHacknSlacksPlayer* pkPlayer, int32 iSlot)
+{
+	if (iSlot < 0 || iSlot >= MaxPlayers)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s has controller id %d, only %d local players are supported"), *pkPlayer->GetName(), iSlot, MaxPlayers);
+		return INDEX_NONE;
+	}
+
+	AHacknSlacksPlayer* pkExisting = apkPlayers[iSlot].Get();
+
+	if (pkExisting && pkExisting != pkPlayer && !pkExisting->IsPendingKill())
+		return INDEX_NONE;
+
+	// a player moving to a new slot leaves its old one
+	Unregister(pkPlayer);
+
+	apkPlayers[iSlot] = pkPlayer;
+
+	return iSlot;
+}
+
+void FPlayerRegistry::Unregister(AHacknSlacksPlayer* pkPlayer)
+{
+	for (int32 iSlot = 0; iSlot < MaxPlayers; iSlot++)
+		if (apkPlayers[iSlot].Get() == pkPlayer)
+			apkPlayers[iSlot].Reset();
+}
+
+AHacknSlacksPlayer* FPlayerRegistry::GetPlayer(int32 iSlot) const
+{
+	return iSlot >= 0 && iSlot < MaxPlayers ? apkPlayers[iSlot].Get() : nullptr;
+}
+
+int32 FPlayerRegistry::Num() const
+{
+	int32 iNum = 0;
+
+	for (int32 iSlot = 0; iSlot < MaxPlayers; iSlot++)
+		iNum += apkPlayers[iSlot].IsValid() ? 1 : 0;
+
+	return iNum;
+}
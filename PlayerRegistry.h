@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AHacknSlacksPlayer;
+
+// local players in a world by slot, for split-screen - replaces assuming a single player
+// remote players are never registered, the slot is the local player's controller id
+class HACKNSLACKS_API FPlayerRegistry
+{
+public:
+	static const int32 MaxPlayers = 8;
+
+	FPlayerRegistry(UWorld* pkWorld);
+
+	// registry for a world, created on first use and destroyed with the world - game thread only
+	static FPlayerRegistry* Get(UWorld* pkWorld);
+
+	// put a local player in the slot matching its controller id - returns the slot, INDEX_NONE if it is out of range or another player has it
+	int32 Register(AHacknSlacksPlayer* pkPlayer, int32 iSlot);
+
+	void Unregister(AHacknSlacksPlayer* pkPlayer);
+
+	// nullptr for an empty slot
+	AHacknSlacksPlayer* GetPlayer(int32 iSlot) const;
+
+	int32 Num() const;
+
+private:
+	TWeakObjectPtr<AHacknSlacksPlayer> apkPlayers[MaxPlayers];
+};
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SheathMeshes.generated.h"
+
+class AWeapon;
+
+// copies of a weapon's meshes that stay attached to its sheath socket while the weapon is assigned
+USTRUCT()
+struct FSheathMeshes
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSheathMeshes() : pkWeapon(nullptr) {}
+
+	// weapon the meshes were built from
+	UPROPERTY()
+	AWeapon* pkWeapon;
+
+	UPROPERTY()
+	TArray<UStaticMeshComponent*> apkMeshes;
+};
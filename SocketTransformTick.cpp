@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HackNSlacksCharacter.h"
+#include "SocketTransformTick.h"
+
+FSocketTransformTickFunction::FSocketTransformTickFunction()
+{
+	pkTarget = nullptr;
+
+	bCanEverTick = true;
+	bStartWithTickEnabled = true;
+
+	// after animation and physics blending have moved the bones
+	TickGroup = TG_PostPhysics;
+}
+
+void FSocketTransformTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (pkTarget && !pkTarget->IsPendingKill())
+		pkTarget->UpdateSocketTransforms();
+}
+
+FString FSocketTransformTickFunction::DiagnosticMessage()
+{
+	return pkTarget ? pkTarget->GetFullName() + TEXT("[UpdateSocketTransforms]") : TEXT("[UpdateSocketTransforms]");
+}
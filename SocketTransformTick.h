@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Engine/EngineBaseTypes.h"
+#include "SocketTransformTick.generated.h"
+
+class AHackNSlacksCharacter;
+
+// ticks after the character's mesh has finished animating to cache the world transforms of its body part sockets
+USTRUCT()
+struct FSocketTransformTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSocketTransformTickFunction();
+
+	AHackNSlacksCharacter* pkTarget;
+
+	// FTickFunction
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSocketTransformTickFunction> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
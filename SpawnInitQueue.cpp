@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HackNSlacksCharacter.h"
+#include "SpawnInitQueue.h"
+
+FSpawnInitQueue::FSpawnInitQueue()
+{
+	fFrameBudget = 0.002f;
+}
+
+FSpawnInitQueue& FSpawnInitQueue::Get()
+{
+	static FSpawnInitQueue oQueue;
+
+	return oQueue;
+}
+
+void FSpawnInitQueue::Add(AHackNSlacksCharacter* pkCharacter)
+{
+	apkPending.AddUnique(pkCharacter);
+}
+
+void FSpawnInitQueue::Tick(float DeltaTime)
+{
+	double fStartTime = FPlatformTime::Seconds();
+
+	bool bRanStage = false;
+
+	while (apkPending.Num() > 0 && (!bRanStage || FPlatformTime::Seconds() - fStartTime < fFrameBudget))
+	{
+		AHackNSlacksCharacter* pkCharacter = apkPending[0].Get();
+
+		// destroyed before it finished
+		if (!pkCharacter || pkCharacter->IsPendingKill())
+		{
+			apkPending.RemoveAt(0, 1, false);
+			continue;
+		}
+
+		bRanStage = true;
+
+		if (pkCharacter->RunInitStage())
+			apkPending.RemoveAt(0, 1, false);
+	}
+}
+
+bool FSpawnInitQueue::IsTickable() const
+{
+	return apkPending.Num() > 0;
+}
+
+TStatId FSpawnInitQueue::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FSpawnInitQueue, STATGROUP_Tickables);
+}
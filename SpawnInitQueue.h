@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Tickable.h"
+
+class AHackNSlacksCharacter;
+
+// steps of a character's setup after it spawns, run in order
+enum class ESpawnInitStage : uint8
+{
+	// anim instance and attack dictionary
+	Anim,
+	// body part sockets and their bones
+	Sockets,
+	// gather and sort attack colliders
+	Colliders,
+	// spawn or take the starting weapon from the pool
+	Weapon,
+	// mesh merge and attack events, then start ticking and colliding
+	Activate,
+	Done
+};
+
+// runs the init stages of spawned characters within a per-frame budget, so a wave spawning in one frame is set up over several
+class HACKNSLACKS_API FSpawnInitQueue : public FTickableGameObject
+{
+public:
+	FSpawnInitQueue();
+
+	static FSpawnInitQueue& Get();
+
+	void Add(AHackNSlacksCharacter* pkCharacter);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	// seconds of init allowed per frame, at least one stage runs every frame
+	float fFrameBudget;
+
+private:
+	// characters are finished in spawn order, so the first spawned become active first
+	TArray<TWeakObjectPtr<AHackNSlacksCharacter>> apkPending;
+};
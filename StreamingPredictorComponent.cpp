@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HNSNames.h"
+#include "HacknSlacksPlayer.h"
+#include "StreamingPredictorComponent.h"
+
+UStreamingPredictorComponent::UStreamingPredictorComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	fLookAheadTime = 2.0f;
+	iPathSamples = 4;
+	fPreloadRadius = 1500.0f;
+	fCameraLookAhead = 2000.0f;
+	fMemoryBudgetMB = 512.0f;
+	fEvictDelay = 3.0f;
+	fHistoryInterval = 0.25f;
+
+	iHistoryCount = 0;
+	iHistoryHead = 0;
+	fHistoryTimer = 0.0f;
+	fLoadedMB = 0.0f;
+	iNextLatentID = 0;
+}
+
+void UStreamingPredictorComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AHacknSlacksPlayer* pkPlayer = Cast<AHacknSlacksPlayer>(GetOwner());
+
+	if (!pkPlayer || aoChunks.Num() == 0)
+		return;
+
+	// sample the last ground position so jumps and dodges do not throw the prediction off
+	if ((fHistoryTimer += DeltaTime) >= fHistoryInterval)
+	{
+		fHistoryTimer = 0.0f;
+
+		aoGroundHistory[iHistoryHead] = pkPlayer->GetLastGroundPosition();
+		iHistoryHead = (iHistoryHead + 1) % HistorySize;
+		iHistoryCount = FMath::Min(iHistoryCount + 1, HistorySize);
+	}
+
+	FVector oLocation = pkPlayer->GetActorLocation();
+
+	TArray<FVector> aoPoints;
+	PredictPath(oLocation, aoPoints);
+
+	float fTime = GetWorld()->GetTimeSeconds();
+
+	// mark every chunk near the path before loading so eviction never picks one that is wanted this tick
+	for (FStreamingChunk& oChunk : aoChunks)
+	{
+		FBox oPreloadBounds = oChunk.oBounds.ExpandBy(fPreloadRadius);
+
+		bool bWanted = oChunk.oBounds.IsInside(oLocation);
+
+		for (int32 iPoint = 0; iPoint < aoPoints.Num() && !bWanted; iPoint++)
+			bWanted = oPreloadBounds.IsInside(aoPoints[iPoint]);
+
+		if (bWanted)
+			oChunk.fLastWantedTime = fTime;
+	}
+
+	for (FStreamingChunk& oChunk : aoChunks)
+	{
+		// make room first, chunks ahead of the player always win over chunks behind
+		if (oChunk.fLastWantedTime >= fTime && !oChunk.bRequested && (fLoadedMB + oChunk.fMemoryMB <= fMemoryBudgetMB || Evict(oLocation, pkPlayer->GetVelocity(), oChunk.fMemoryMB, fTime)))
+			RequestLoad(oChunk);
+	}
+
+	// drop chunks that have been off the path for a while even when under budget
+	for (FStreamingChunk& oChunk : aoChunks)
+		if (oChunk.bRequested && fTime - oChunk.fLastWantedTime >= fEvictDelay)
+			RequestUnload(oChunk);
+}
+
+void UStreamingPredictorComponent::OnChunkLoaded()
+{
+	if (AHacknSlacksPlayer* pkPlayer = Cast<AHacknSlacksPlayer>(GetOwner()))
+		pkPlayer->OnLevelStreamed();
+}
+
+void UStreamingPredictorComponent::PredictPath(const FVector& oLocation, TArray<FVector>& aoPoints) const
+{
+	AHacknSlacksPlayer* pkPlayer = Cast<AHacknSlacksPlayer>(GetOwner());
+
+	FVector oVelocity = pkPlayer->GetVelocity();
+
+	// average ground velocity over the history, oldest sample is at the head once the buffer is full
+	if (iHistoryCount > 1)
+	{
+		int32 iOldest = iHistoryCount < HistorySize ? 0 : iHistoryHead;
+		int32 iNewest = (iHistoryHead + HistorySize - 1) % HistorySize;
+
+		FVector oHistoryVelocity = (aoGroundHistory[iNewest] - aoGroundHistory[iOldest]) / (fHistoryInterval * (iHistoryCount - 1));
+
+		oVelocity = (oVelocity + oHistoryVelocity) * 0.5f;
+	}
+
+	oVelocity.Z = 0.0f;
+
+	for (int32 iSample = 1; iSample <= iPathSamples; iSample++)
+		aoPoints.Add(oLocation + oVelocity * (fLookAheadTime * iSample / iPathSamples));
+
+	if (UCameraComponent* pkCamera = pkPlayer->GetFollowCamera())
+		aoPoints.Add(oLocation + pkCamera->GetForwardVector().GetSafeNormal2D() * fCameraLookAhead);
+}
+
+void UStreamingPredictorComponent::RequestLoad(FStreamingChunk& oChunk)
+{
+	FLatentActionInfo oLatentInfo;
+	oLatentInfo.CallbackTarget = this;
+	oLatentInfo.ExecutionFunction = FHNSNames::OnChunkLoaded;
+	oLatentInfo.UUID = iNextLatentID++;
+	oLatentInfo.Linkage = 0;
+
+	UGameplayStatics::LoadStreamLevel(this, oChunk.sLevelName, true, false, oLatentInfo);
+
+	oChunk.bRequested = true;
+	fLoadedMB += oChunk.fMemoryMB;
+}
+
+void UStreamingPredictorComponent::RequestUnload(FStreamingChunk& oChunk)
+{
+	FLatentActionInfo oLatentInfo;
+	oLatentInfo.UUID = iNextLatentID++;
+
+	UGameplayStatics::UnloadStreamLevel(this, oChunk.sLevelName, oLatentInfo);
+
+	oChunk.bRequested = false;
+	fLoadedMB = FMath::Max(0.0f, fLoadedMB - oChunk.fMemoryMB);
+}
+
+bool UStreamingPredictorComponent::Evict(const FVector& oLocation, const FVector& oVelocity, float fNeededMB, float fTime)
+{
+	while (fLoadedMB + fNeededMB > fMemoryBudgetMB)
+	{
+		FStreamingChunk* poEvict = nullptr;
+
+		// unwanted chunk that has been off the path the longest, preferring chunks behind the player
+		for (FStreamingChunk& oChunk : aoChunks)
+		{
+			if (!oChunk.bRequested || oChunk.fLastWantedTime >= fTime)
+				continue;
+
+			bool bBehind = FVector::DotProduct(oChunk.oBounds.GetCenter() - oLocation, oVelocity) < 0.0f;
+			bool bEvictBehind = poEvict && FVector::DotProduct(poEvict->oBounds.GetCenter() - oLocation, oVelocity) < 0.0f;
+
+			if (!poEvict || (bBehind && !bEvictBehind) || (bBehind == bEvictBehind && oChunk.fLastWantedTime < poEvict->fLastWantedTime))
+				poEvict = &oChunk;
+		}
+
+		if (!poEvict)
+			return false;
+
+		RequestUnload(*poEvict);
+	}
+
+	return true;
+}
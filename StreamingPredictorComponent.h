@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "StreamingPredictorComponent.generated.h"
+
+// a streaming level and the area of the world it covers
+USTRUCT()
+struct FStreamingChunk
+{
+	GENERATED_USTRUCT_BODY()
+
+	FStreamingChunk() : sLevelName(NAME_None), oBounds(0), fMemoryMB(64.0f), bRequested(false), fLastWantedTime(-BIG_NUMBER) {}
+
+	// streaming level package name
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	FName sLevelName;
+
+	// world space area covered by the level
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	FBox oBounds;
+
+	// estimated memory cost of the level while loaded, in megabytes
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float fMemoryMB;
+
+	// a load has been issued and not unloaded since
+	bool bRequested;
+
+	// last time the chunk was near the predicted path
+	float fLastWantedTime;
+};
+
+// loads level chunks ahead of the player using their velocity, recent ground positions and camera direction, and unloads chunks left behind
+UCLASS(ClassGroup = Streaming, meta = (BlueprintSpawnableComponent))
+class HACKNSLACKS_API UStreamingPredictorComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UStreamingPredictorComponent(const FObjectInitializer& ObjectInitializer);
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// latent callback when a requested chunk has finished loading
+	UFUNCTION()
+	void OnChunkLoaded();
+
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	TArray<FStreamingChunk> aoChunks;
+
+	// how many seconds ahead of the player to predict their position
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float fLookAheadTime;
+
+	// number of points checked along the predicted path
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	int32 iPathSamples;
+
+	// distance around each predicted point that should be loaded
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float fPreloadRadius;
+
+	// distance along the camera direction that should be loaded
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float fCameraLookAhead;
+
+	// total memory allowed for chunks loaded by the predictor, in megabytes
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float fMemoryBudgetMB;
+
+	// how long a chunk must be away from the predicted path before it is unloaded
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float fEvictDelay;
+
+	// seconds between ground position history samples
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float fHistoryInterval;
+
+protected:
+	// fill in the points the player is expected to pass through or look at
+	void PredictPath(const FVector& oLocation, TArray<FVector>& aoPoints) const;
+
+	void RequestLoad(FStreamingChunk& oChunk);
+
+	void RequestUnload(FStreamingChunk& oChunk);
+
+	// unload unwanted chunks behind the player until there is room for fNeededMB, or until only recent chunks are left
+	bool Evict(const FVector& oLocation, const FVector& oVelocity, float fNeededMB, float fTime);
+
+	// ground positions sampled every fHistoryInterval, oldest overwritten first
+	static const int32 HistorySize = 8;
+
+	FVector aoGroundHistory[HistorySize];
+
+	int32 iHistoryCount;
+
+	int32 iHistoryHead;
+
+	float fHistoryTimer;
+
+	// memory used by chunks the predictor has requested
+	float fLoadedMB;
+
+	// every latent load needs its own id or later requests replace earlier ones
+	int32 iNextLatentID;
+};
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "Enemy.h"
+#include "HacknSlacksPlayer.h"
+#include "PlayerRegistry.h"
+#include "AngleMath.h"
+#include "PerWorld.h"
+#include "TargetingSnapshot.h"
+
+static_assert(FPlayerRegistry::MaxPlayers <= 8, "nearby masks hold one bit per player slot");
+
+FTargetingSnapshot::FTargetingSnapshot(UWorld* pkWorld)
+{
+	iFrame = 0;
+}
+
+const FTargetingSnapshot* FTargetingSnapshot::Get(UWorld* pkWorld)
+{
+	FTargetingSnapshot* poSnapshot = TPerWorld<FTargetingSnapshot>::Get(pkWorld);
+
+	if (poSnapshot && poSnapshot->iFrame != GFrameCounter)
+		poSnapshot->Build(pkWorld);
+
+	return poSnapshot;
+}
+
+void FTargetingSnapshot::Build(UWorld* pkWorld)
+{
+	iFrame = GFrameCounter;
+
+	aoLocations.Reset();
+	aiNearbyMasks.Reset();
+	apkEnemies.Reset();
+	kIndices.Reset();
+
+	FPlayerRegistry* poPlayers = FPlayerRegistry::Get(pkWorld);
+
+	for (int32 iSlot = 0; iSlot < FPlayerRegistry::MaxPlayers; iSlot++)
+	{
+		AHacknSlacksPlayer* pkPlayer = poPlayers->GetPlayer(iSlot);
+
+		if (!pkPlayer)
+			continue;
+
+		// drop dead enemies once here instead of in every query
+		pkPlayer->PruneNearbyEnemies();
+
+		for (auto pkEnemyIter = pkPlayer->GetNearbyEnemies().GetHead(); pkEnemyIter; pkEnemyIter = pkEnemyIter->GetNextNode())
+		{
+			AEnemy* pkEnemy = pkEnemyIter->GetValue();
+
+			int32 iTarget;
+
+			if (const int32* piTarget = kIndices.Find(pkEnemy))
+				iTarget = *piTarget;
+			else
+			{
+				iTarget = apkEnemies.Add(pkEnemy);
+				aoLocations.Add(pkEnemy->GetActorLocation());
+				aiNearbyMasks.Add(0);
+
+				kIndices.Add(pkEnemy, iTarget);
+			}
+
+			aiNearbyMasks[iTarget] |= 1 << iSlot;
+		}
+	}
+}
+
+int32 FTargetingSnapshot::FindClosestAngle(int32 iSlot, const FVector& oFrom, float fTargetYaw) const
+{
+	if (iSlot < 0 || iSlot >= FPlayerRegistry::MaxPlayers)
+		return INDEX_NONE;
+
+	const uint8 iMask = 1 << iSlot;
+
+	int32 iClosest = INDEX_NONE;
+	float fMinAngleDiff = 0.0f;
+
+	for (int32 iTarget = 0; iTarget < aoLocations.Num(); iTarget++)
+	{
+		if (!(aiNearbyMasks[iTarget] & iMask))
+			continue;
+
+		// closest to zero, sign doesn't matter
+		float fAngleDiff = FMath::Abs(FAngleMath::Diff(FAngleMath::Yaw(aoLocations[iTarget] - oFrom), fTargetYaw));
+
+		if (iClosest == INDEX_NONE || fAngleDiff < fMinAngleDiff)
+		{
+			iClosest = iTarget;
+			fMinAngleDiff = fAngleDiff;
+		}
+	}
+
+	return iClosest;
+}
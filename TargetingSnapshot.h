@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AEnemy;
+
+// enemies near any local player, packed once per frame so every player's soft lock query reads the same contiguous arrays
+class HACKNSLACKS_API FTargetingSnapshot
+{
+public:
+	FTargetingSnapshot(UWorld* pkWorld);
+
+	// snapshot for a world, rebuilt on the first call each frame - game thread only
+	static const FTargetingSnapshot* Get(UWorld* pkWorld);
+
+	// nearby enemy whose yaw from oFrom is closest to fTargetYaw, for the player in iSlot - INDEX_NONE if the player has none nearby
+	int32 FindClosestAngle(int32 iSlot, const FVector& oFrom, float fTargetYaw) const;
+
+	FORCEINLINE int32 Num() const { return apkEnemies.Num(); }
+
+	FORCEINLINE AEnemy* GetEnemy(int32 iTarget) const { return apkEnemies.IsValidIndex(iTarget) ? apkEnemies[iTarget] : nullptr; }
+
+	// location when the snapshot was built
+	FORCEINLINE const FVector& GetLocation(int32 iTarget) const { return aoLocations[iTarget]; }
+
+private:
+	void Build(UWorld* pkWorld);
+
+	uint64 iFrame;
+
+	TArray<FVector> aoLocations;
+
+	// bit per player slot that has the enemy nearby
+	TArray<uint8> aiNearbyMasks;
+
+	TArray<AEnemy*> apkEnemies;
+
+	// build scratch, kept to avoid reallocating every frame
+	TMap<AEnemy*, int32> kIndices;
+};
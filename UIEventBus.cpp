@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "HacknSlacksPlayer.h"
+#include "UIEventBus.h"
+
+FUIEventBus::FUIEventBus()
+{
+	bComboIncreased = false;
+	iComboCount = 0;
+
+	bComboReset = false;
+	iResetFromCount = 0;
+
+	bBuffsChanged = false;
+}
+
+void FUIEventBus::ComboCountIncreased(int32 iNewCount)
+{
+	bComboIncreased = true;
+	iComboCount = iNewCount;
+}
+
+void FUIEventBus::ComboCountReset(int32 iLastCount)
+{
+	// a reset replaces any increase earlier in the frame
+	if (!bComboReset || bComboIncreased)
+		iResetFromCount = iLastCount;
+
+	bComboReset = true;
+	bComboIncreased = false;
+	iComboCount = 0;
+}
+
+void FUIEventBus::BuffSlotAdded(int32 iActiveBuffsBefore)
+{
+	BeginBuffChanges(iActiveBuffsBefore);
+
+	aiSlotOrigins.Add(INDEX_NONE);
+}
+
+void FUIEventBus::BuffSlotRemoved(int32 iSlot, int32 iActiveBuffsBefore)
+{
+	BeginBuffChanges(iActiveBuffsBefore);
+
+	if (!aiSlotOrigins.IsValidIndex(iSlot))
+		return;
+
+	// buffs added and removed in the same frame never reach the widget
+	if (aiSlotOrigins[iSlot] != INDEX_NONE)
+		aiRemovedSlots.Add(aiSlotOrigins[iSlot]);
+
+	aiSlotOrigins.RemoveAt(iSlot);
+}
+
+bool FUIEventBus::HasPending() const
+{
+	return bComboIncreased || bComboReset || bBuffsChanged;
+}
+
+void FUIEventBus::Flush(AHacknSlacksPlayer* pkPlayer)
+{
+	if (bComboReset)
+		pkPlayer->OnComboCountReset(iResetFromCount);
+
+	if (bComboIncreased)
+		pkPlayer->OnComboCountIncreased(iComboCount);
+
+	if (bBuffsChanged)
+	{
+		TArray<int32> aiAddedSlots;
+
+		for (int32 iSlot = 0; iSlot < aiSlotOrigins.Num(); iSlot++)
+			if (aiSlotOrigins[iSlot] == INDEX_NONE)
+				aiAddedSlots.Add(iSlot);
+
+		// removed slots are in start of frame order, highest first so the widget can remove them one by one
+		aiRemovedSlots.Sort([](int32 iA, int32 iB) { return iA > iB; });
+
+		if (aiAddedSlots.Num() > 0 || aiRemovedSlots.Num() > 0)
+			pkPlayer->OnBuffSlotsChanged(aiRemovedSlots, aiAddedSlots);
+	}
+
+	bComboIncreased = false;
+	bComboReset = false;
+	bBuffsChanged = false;
+
+	aiSlotOrigins.Reset();
+	aiRemovedSlots.Reset();
+}
+
+void FUIEventBus::BeginBuffChanges(int32 iActiveBuffs)
+{
+	if (bBuffsChanged)
+		return;
+
+	bBuffsChanged = true;
+
+	for (int32 iSlot = 0; iSlot < iActiveBuffs; iSlot++)
+		aiSlotOrigins.Add(iSlot);
+}
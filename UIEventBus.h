@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AHacknSlacksPlayer;
+
+// collects combo and buff notifications during a frame and hands the player's widgets one coalesced update
+struct HACKNSLACKS_API FUIEventBus
+{
+	FUIEventBus();
+
+	void ComboCountIncreased(int32 iNewCount);
+
+	void ComboCountReset(int32 iLastCount);
+
+	// a buff took the slot at the end of the buff bar
+	void BuffSlotAdded(int32 iActiveBuffsBefore);
+
+	// a buff left its slot and the slots after it shift left
+	void BuffSlotRemoved(int32 iSlot, int32 iActiveBuffsBefore);
+
+	bool HasPending() const;
+
+	// deliver everything collected since the last flush to the player's blueprint events
+	void Flush(AHacknSlacksPlayer* pkPlayer);
+
+private:
+	// start tracking the buff bar as it was at the first change this frame
+	void BeginBuffChanges(int32 iActiveBuffs);
+
+	bool bComboIncreased;
+	int32 iComboCount;
+
+	bool bComboReset;
+	int32 iResetFromCount;
+
+	bool bBuffsChanged;
+
+	// for each slot in the current buff bar, the slot it had at the start of the frame, or INDEX_NONE if added this frame
+	TArray<int32> aiSlotOrigins;
+
+	// slots from the start of the frame that have been removed
+	TArray<int32> aiRemovedSlots;
+};
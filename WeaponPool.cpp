@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HacknSlacks.h"
+#include "Weapon.h"
+#include "PerWorld.h"
+#include "WeaponPool.h"
+
+namespace
+{
+	void ReportWeaponPools()
+	{
+		for (auto& kPool : TPerWorld<FWeaponPool>::GetAll())
+		{
+			if (kPool.Key.IsValid())
+			{
+				UE_LOG(LogTemp, Log, TEXT("Weapon pool for %s"), *kPool.Key->GetName());
+				kPool.Value->ReportStats();
+			}
+		}
+	}
+
+	FAutoConsoleCommand GWeaponPoolCommand(
+		TEXT("HNS.WeaponPool"),
+		TEXT("Log free and in use pooled weapons per type"),
+		FConsoleCommandDelegate::CreateStatic(&ReportWeaponPools));
+}
+
+FWeaponPool::FWeaponPool(UWorld* pkWorld)
+{
+	FMemory::Memzero(aiOwned);
+}
+
+FWeaponPool* FWeaponPool::Get(UWorld* pkWorld)
+{
+	return TPerWorld<FWeaponPool>::Get(pkWorld);
+}
+
+void FWeaponPool::Prewarm(const FWeaponSpawnStruct& oSpawn, int32 iCount)
+{
+	if (oSpawn.eWeaponType == EWeaponTypes::Count)
+		return;
+
+	for (int32 iExisting = aiOwned[(int32)oSpawn.eWeaponType]; iExisting < iCount; iExisting++)
+	{
+		AWeapon* pkWeapon = Spawn(oSpawn);
+
+		if (!pkWeapon)
+			break;
+
+		Deactivate(pkWeapon);
+		aapkFree[(int32)oSpawn.eWeaponType].Add(pkWeapon);
+	}
+}
+
+AWeapon* FWeaponPool::Acquire(const FWeaponSpawnStruct& oSpawn)
+{
+	if (oSpawn.eWeaponType == EWeaponTypes::Count)
+		return nullptr;
+
+	TArray<TWeakObjectPtr<AWeapon>>& apkFree = aapkFree[(int32)oSpawn.eWeaponType];
+
+	// weapons destroyed while pooled, e.g. by level streaming, are skipped and forgotten
+	while (apkFree.Num() > 0)
+	{
+		TWeakObjectPtr<AWeapon> pkFree = apkFree.Pop(false);
+		AWeapon* pkWeapon = pkFree.Get();
+
+		if (pkWeapon && !pkWeapon->IsPendingKill())
+		{
+			Activate(pkWeapon);
+			return pkWeapon;
+		}
+
+		if (kOwned.Remove(pkFree) > 0)
+			aiOwned[(int32)oSpawn.eWeaponType]--;
+	}
+
+	return Spawn(oSpawn);
+}
+
+bool FWeaponPool::Owns(AWeapon* pkWeapon) const
+{
+	return pkWeapon && kOwned.Contains(pkWeapon);
+}
+
+bool FWeaponPool::Release(AWeapon* pkWeapon)
+{
+	EWeaponTypes* peType = pkWeapon ? kOwned.Find(pkWeapon) : nullptr;
+
+	if (!peType || pkWeapon->IsPendingKill())
+		return false;
+
+	TArray<TWeakObjectPtr<AWeapon>>& apkFree = aapkFree[(int32)*peType];
+
+	if (apkFree.Contains(pkWeapon))
+		return true;
+
+	Deactivate(pkWeapon);
+	apkFree.Add(pkWeapon);
+
+	return true;
+}
+
+AWeapon* FWeaponPool::Spawn(const FWeaponSpawnStruct& oSpawn)
+{
+	AWeapon* pkWeapon = oSpawn.SpawnWeapon();
+
+	if (pkWeapon)
+	{
+		kOwned.Add(pkWeapon, oSpawn.eWeaponType);
+		aiOwned[(int32)oSpawn.eWeaponType]++;
+	}
+
+	return pkWeapon;
+}
+
+void FWeaponPool::Deactivate(AWeapon* pkWeapon)
+{
+	pkWeapon->fCharge = 0.0f;
+	pkWeapon->pkOwner = nullptr;
+
+	pkWeapon->SetActorHiddenInGame(true);
+	pkWeapon->SetActorEnableCollision(false);
+	pkWeapon->SetActorTickEnabled(false);
+}
+
+void FWeaponPool::Activate(AWeapon* pkWeapon)
+{
+	pkWeapon->SetActorHiddenInGame(false);
+	pkWeapon->SetActorEnableCollision(true);
+	pkWeapon->SetActorTickEnabled(true);
+}
+
+void FWeaponPool::ReportStats() const
+{
+	int32 aiOwned[(int32)EWeaponTypes::Count] = {};
+
+	for (auto& kWeapon : kOwned)
+		if (kWeapon.Key.IsValid())
+			aiOwned[(int32)kWeapon.Value]++;
+
+	for (int32 iType = 0; iType < (int32)EWeaponTypes::Count; iType++)
+	{
+		if (aiOwned[iType] == 0)
+			continue;
+
+		int32 iFree = 0;
+
+		for (const TWeakObjectPtr<AWeapon>& pkWeapon : aapkFree[iType])
+			iFree += pkWeapon.IsValid() ? 1 : 0;
+
+		UE_LOG(LogTemp, Log, TEXT("  type %d: %d free, %d in use"), iType, iFree, aiOwned[iType] - iFree);
+	}
+}
+
+AWeaponPoolSettings::AWeaponPoolSettings(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+}
+
+void AWeaponPoolSettings::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FWeaponPool* poPool = FWeaponPool::Get(GetWorld());
+
+	if (!poPool)
+		return;
+
+	for (const FWeaponPoolEntry& oEntry : aoWeapons)
+		poPool->Prewarm(oEntry.oSpawn, oEntry.iCount);
+}
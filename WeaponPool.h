@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "WeaponSpawn.h"
+#include "WeaponPool.generated.h"
+
+class AWeapon;
+
+// hidden weapons of each type kept between owners, so arming a wave of characters reuses actors instead of spawning them
+class HACKNSLACKS_API FWeaponPool
+{
+public:
+	FWeaponPool(UWorld* pkWorld);
+
+	// pool for a world, created on first use and destroyed with the world - game thread only
+	static FWeaponPool* Get(UWorld* pkWorld);
+
+	// spawn weapons until at least iCount of the type exist, counting the ones in use - done once when the level loads
+	void Prewarm(const FWeaponSpawnStruct& oSpawn, int32 iCount);
+
+	// a pooled weapon of the type if one is free, otherwise a newly spawned one - nullptr if spawning failed
+	AWeapon* Acquire(const FWeaponSpawnStruct& oSpawn);
+
+	bool Owns(AWeapon* pkWeapon) const;
+
+	// hide a weapon that came from the pool until it is acquired again - returns false if the pool does not own it
+	bool Release(AWeapon* pkWeapon);
+
+	// log free and in use weapons per type
+	void ReportStats() const;
+
+private:
+	// hide the weapon and stop it ticking and colliding
+	static void Deactivate(AWeapon* pkWeapon);
+
+	static void Activate(AWeapon* pkWeapon);
+
+	AWeapon* Spawn(const FWeaponSpawnStruct& oSpawn);
+
+	TArray<TWeakObjectPtr<AWeapon>> aapkFree[(int32)EWeaponTypes::Count];
+
+	// every weapon the pool created and its type
+	TMap<TWeakObjectPtr<AWeapon>, EWeaponTypes> kOwned;
+
+	// kOwned per type, so prewarming does not walk the map - lowered when a destroyed weapon turns up in the free list
+	int32 aiOwned[(int32)EWeaponTypes::Count];
+};
+
+USTRUCT()
+struct FWeaponPoolEntry
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, Category = WeaponPool)
+	FWeaponSpawnStruct oSpawn;
+
+	UPROPERTY(EditAnywhere, Category = WeaponPool)
+	int32 iCount;
+
+	FWeaponPoolEntry() : iCount(0) {}
+};
+
+// placed in a level to fill the weapon pool when the level begins play - characters only arm themselves later, in their
+// time sliced init, so placed characters and the waves after them all take pooled weapons
+UCLASS()
+class HACKNSLACKS_API AWeaponPoolSettings : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AWeaponPoolSettings(const FObjectInitializer& ObjectInitializer);
+
+	virtual void BeginPlay() override;
+
+	// weapons of each type kept ready for the level
+	UPROPERTY(EditAnywhere, Category = WeaponPool)
+	TArray<FWeaponPoolEntry> aoWeapons;
+};